@@ -0,0 +1,312 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/flat_ast.hpp"
+#include "corpus.hpp"
+
+/*
+    AST traversal benchmark.
+
+    Parses a program from CorpusGenerator and walks the whole tree once per
+    run, counting identifiers and summing integer literals, in three ways:
+
+    * pointer: recursion over the Parser's tree, through the std::variants
+    * flat: the same recursion over FlatAst, through 32-bit child indices
+    * flat scan: one pass over the FlatAst node array in index order, which
+      is all a visit that does not care about tree order needs
+
+    All three must agree on the totals. Building the FlatAst is timed too,
+    it is the cost of getting from the first representation to the second.
+
+    usage: ast_bench.o [size in MB] [iterations]
+*/
+
+struct Totals {
+    std::size_t identifiers = 0;
+    int64_t integers = 0;
+
+    bool operator==(const Totals&) const = default;
+};
+
+class PointerWalk {
+private:
+    Totals m_totals;
+
+    void identifier(NodeIdentifier* node) {
+        if (!node) return;
+        identifier(node->_access_token);
+        std::visit([&](auto* inner) {
+            using T = std::remove_pointer_t<decltype(inner)>;
+            if (!inner) return;
+            if constexpr (std::is_same_v<T, NodeIdentifierToken>) {
+                m_totals.identifiers++;
+            } else if constexpr (std::is_same_v<T, NodeTupleIdentifier>) {
+                for (NodeIdentifier* item : inner->_identifiers) identifier(item);
+            } else if constexpr (std::is_same_v<T, NodeArrayIndex>) {
+                identifier(inner->_identifier);
+                expression(inner->_expression);
+            } else {
+                functionCall(inner);
+            }
+        }, node->_identifier);
+    }
+
+    void functionCall(NodeFunctionCall* node) {
+        if (!node) return;
+        identifier(node->_identifier);
+        for (NodeFunctionCallArgument* argument : node->_arguments) {
+            if (argument) expression(argument->_expression);
+        }
+    }
+
+    void expression(NodeExpression* node) {
+        if (!node) return;
+        std::visit([&](auto* inner) {
+            using T = std::remove_pointer_t<decltype(inner)>;
+            if (!inner) return;
+            if constexpr (std::is_same_v<T, NodeExpressionBinary> || std::is_same_v<T, NodeAssign>) {
+                expression(inner->_lhs);
+                expression(inner->_rhs);
+            } else if constexpr (std::is_same_v<T, NodeExpressionUnary>) {
+                expression(inner->_expression);
+            } else if constexpr (std::is_same_v<T, NodeInteger>) {
+                m_totals.integers += inner->_value;
+            } else if constexpr (std::is_same_v<T, NodeFunctionCall>) {
+                functionCall(inner);
+            } else if constexpr (std::is_same_v<T, NodeTuple>) {
+                for (NodeExpression* item : inner->_expressions) expression(item);
+            } else if constexpr (std::is_same_v<T, NodeList>) {
+                for (NodeExpression* item : inner->_items) expression(item);
+            } else if constexpr (std::is_same_v<T, NodeIdentifier>) {
+                identifier(inner);
+            } else if constexpr (std::is_same_v<T, NodeStatement>) {
+                statement(inner);
+            } else if constexpr (std::is_same_v<T, NodeRange>) {
+                expression(inner->_start);
+                expression(inner->_end);
+            } else if constexpr (std::is_same_v<T, NodeCall>) {
+                functionCall(inner->_function_call);
+            }
+        }, node->_expression);
+    }
+
+    void statement(NodeStatement* node) {
+        if (!node) return;
+        std::visit([&](auto* inner) {
+            using T = std::remove_pointer_t<decltype(inner)>;
+            if (!inner) return;
+            if constexpr (std::is_same_v<T, NodeDecleration>) {
+                identifier(inner->_identifier);
+                expression(inner->_expression);
+            } else if constexpr (std::is_same_v<T, NodeBlock>) {
+                for (NodeProgramElement* item : inner->_elements) element(item);
+            } else if constexpr (std::is_same_v<T, NodeControl>) {
+                expression(inner->_if.first);
+                statement(inner->_if.second);
+                for (auto& [condition, body] : inner->_else_if) {
+                    expression(condition);
+                    statement(body);
+                }
+                statement(inner->_statement_else);
+            } else if constexpr (std::is_same_v<T, NodeReturn>) {
+                expression(inner->_expression);
+            } else if constexpr (std::is_same_v<T, NodeStream>) {
+                expression(inner->_expression);
+            } else if constexpr (std::is_same_v<T, NodeLoop>) {
+                expression(inner->_expression);
+                statement(inner->_statement);
+            } else if constexpr (std::is_same_v<T, NodeCall>) {
+                functionCall(inner->_function_call);
+            } else if constexpr (std::is_same_v<T, NodeAssign>) {
+                expression(inner->_lhs);
+                expression(inner->_rhs);
+            }
+        }, node->_statement);
+    }
+
+    void element(NodeProgramElement* node) {
+        if (!node) return;
+        if (auto inner = std::get_if<NodeStatement*>(&node->_element)) {
+            statement(*inner);
+        } else if (auto inner = std::get_if<NodeFunctionDecleration*>(&node->_element)) {
+            NodeFunctionDecleration* function = *inner;
+            identifier(function->_identifier);
+            for (NodeFunctionDeclerationArgument* argument : function->_arguments) {
+                if (argument) identifier(argument->_identifier);
+            }
+            statement(function->_statement);
+            expression(function->_expression);
+        }
+    }
+
+public:
+    Totals run(NodeProgram* program) {
+        m_totals = {};
+        for (NodeProgramElement* item : program->_elements) element(item);
+        return m_totals;
+    }
+};
+
+class FlatWalk {
+private:
+    const FlatAst& m_ast;
+    Totals m_totals;
+
+    void visit(FlatIndex index) {
+        if (index == NO_NODE) return;
+        const FlatNode& node = m_ast.node(index);
+
+        switch (m_ast.kind(index)) {
+            case FlatKind::_integer:
+                m_totals.integers += m_ast.integerValue(index);
+                break;
+            case FlatKind::_identifier:
+                m_totals.identifiers++;
+                visit(node.a);
+                break;
+            case FlatKind::_binary:
+            case FlatKind::_assign:
+            case FlatKind::_range:
+                visit(node.a);
+                visit(node.b);
+                break;
+            case FlatKind::_unary:
+            case FlatKind::_call:
+            case FlatKind::_statement_expression:
+            case FlatKind::_return:
+                visit(node.a);
+                break;
+            case FlatKind::_function_call:
+                visit(node.a);
+                for (FlatIndex child : m_ast.children(index)) visit(child);
+                break;
+            case FlatKind::_tuple:
+            case FlatKind::_list:
+            case FlatKind::_block:
+                for (FlatIndex child : m_ast.children(index)) visit(child);
+                break;
+            case FlatKind::_identifier_tuple:
+                visit(node.a);
+                for (FlatIndex child : m_ast.children(index)) visit(child);
+                break;
+            case FlatKind::_identifier_index:
+                visit(node.a);
+                visit(node.b);
+                visit(node.c);
+                break;
+            case FlatKind::_identifier_call:
+                visit(node.a);
+                visit(node.b);
+                break;
+            case FlatKind::_decleration:
+                visit(node.b);
+                visit(node.c);
+                break;
+            case FlatKind::_control:
+                for (FlatIndex child : m_ast.children(node.b, 2 * node.c)) visit(child);
+                visit(node.a);
+                break;
+            case FlatKind::_stream:
+                visit(node.b);
+                break;
+            case FlatKind::_loop:
+                visit(node.a);
+                visit(node.b);
+                break;
+            case FlatKind::_function:
+            case FlatKind::_procedure:
+                visit(node.a);
+                for (FlatIndex argument : m_ast.children(index)) {
+                    if (argument != NO_NODE) visit(m_ast.node(argument).b);
+                }
+                visit(m_ast.bodyStatement(index));
+                visit(m_ast.bodyExpression(index));
+                break;
+            default:
+                break;
+        }
+    }
+
+public:
+    explicit FlatWalk(const FlatAst& ast) : m_ast(ast) {}
+
+    Totals run() {
+        m_totals = {};
+        for (FlatIndex element : m_ast.elements()) visit(element);
+        return m_totals;
+    }
+};
+
+// every node once, in index order; the totals only depend on which nodes exist
+Totals flatScan(const FlatAst& ast) {
+    Totals totals;
+    for (FlatIndex i = 0; i < ast.size(); i++) {
+        if (ast.kind(i) == FlatKind::_integer) {
+            totals.integers += ast.integerValue(i);
+        } else if (ast.kind(i) == FlatKind::_identifier) {
+            totals.identifiers++;
+        }
+    }
+    return totals;
+}
+
+template <typename Run>
+double bestMillis(int iterations, Run run) {
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds * 1e3;
+}
+
+int main(int argc, char* argv[]) {
+    CorpusOptions options;
+    options.size = (argc > 1 ? std::stoul(argv[1]) : 4) * 1024 * 1024;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::string source = CorpusGenerator(options).generate();
+    Tokenizer tokenizer(source);
+    Parser parser(tokenizer.tokenize());
+    NodeProgram* program = parser.parse();
+
+    FlatAst ast;
+    double build = bestMillis(iterations, [&] {
+        ast = FlatAst(program);
+    });
+
+    Totals pointer_totals, flat_totals, scan_totals;
+    PointerWalk pointer_walk;
+    FlatWalk flat_walk(ast);
+
+    double pointer = bestMillis(iterations, [&] {
+        pointer_totals = pointer_walk.run(program);
+    });
+    double flat = bestMillis(iterations, [&] {
+        flat_totals = flat_walk.run();
+    });
+    double scan = bestMillis(iterations, [&] {
+        scan_totals = flatScan(ast);
+    });
+
+    if (!(pointer_totals == flat_totals) || !(pointer_totals == scan_totals)) {
+        std::cerr << "walks disagree: " << pointer_totals.identifiers << "/" << flat_totals.identifiers << "/" << scan_totals.identifiers
+            << " identifiers" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "input:        " << source.size() / (1024 * 1024) << " MB, " << ast.size() << " flat nodes, "
+        << ast.bytes() / 1024 << " KB" << std::endl;
+    std::cout << "build flat:   " << build << " ms" << std::endl;
+    std::cout << "pointer walk: " << pointer << " ms" << std::endl;
+    std::cout << "flat walk:    " << flat << " ms" << std::endl;
+    std::cout << "flat scan:    " << scan << " ms" << std::endl;
+    std::cout << "speedup:      " << pointer / flat << "x walk, " << pointer / scan << "x scan" << std::endl;
+
+    return EXIT_SUCCESS;
+}
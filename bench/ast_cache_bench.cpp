@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/ast_cache.hpp"
+#include "corpus.hpp"
+
+/*
+    Precompiled AST benchmark.
+
+    Writes a program from CorpusGenerator to a temporary file and compares
+    getting its FlatAst the cold way, running the Tokenizer and the Parser
+    and flattening the result, against the warm way, loading a `.gazast`
+    file written for it with AstCache. Both read the source through
+    SourceFile like the compiler does, and the warm load includes hashing
+    the source to validate the file. The loaded AST is compared node by
+    node with the parsed one, token names and literals included.
+
+    Before measuring, a cache file for a small program is written with one
+    node operand at a time pointed outside the AST or back at its own node,
+    each must load as a miss.
+
+    usage: ast_cache_bench.o [size in MB] [iterations]
+*/
+
+bool sameAst(const FlatAst& expected, const FlatAst& actual) {
+    if (expected.size() != actual.size() || expected.elements().size() != actual.elements().size()) return false;
+
+    for (FlatIndex i = 0; i < expected.size(); i++) {
+        const FlatNode& a = expected.node(i);
+        const FlatNode& b = actual.node(i);
+        if (expected.kind(i) != actual.kind(i) || a.a != b.a || a.b != b.b || a.c != b.c) return false;
+
+        const Token* token_a = expected.token(i);
+        const Token* token_b = actual.token(i);
+        if (!token_a != !token_b) return false;
+        if (!token_a) continue;
+
+        if (token_a->getTokenType() != token_b->getTokenType() || token_a->getOffset() != token_b->getOffset() ||
+            token_a->getStrValue() != token_b->getStrValue() || token_a->getSymbol() != token_b->getSymbol()) {
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < expected.elements().size(); i++) {
+        if (expected.elements()[i] != actual.elements()[i]) return false;
+    }
+    return true;
+}
+
+bool checkCorruptOperands() {
+    std::string path = "ast_cache_corrupt.gaz";
+    std::string content = "function f(integer a) returns integer { var integer x = a + 1; { x = x * 2; } return x; }\n"
+        "var integer y = f(1);\n";
+
+    Tokenizer tokenizer(content);
+    Parser parser(tokenizer.tokenize());
+    FlatAst ast(parser.parse());
+
+    AstCache cache(AstCache::pathFor(path));
+    if (!cache.save(content, ast) || !cache.load(content)) return false;
+
+    std::string file;
+    {
+        std::ifstream in(AstCache::pathFor(path), std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // the program has no literals, so the nodes are stored exactly as they are in memory
+    std::string nodes(reinterpret_cast<const char*>(&ast.node(0)), ast.size() * sizeof(FlatNode));
+    std::size_t nodes_at = file.find(nodes);
+    if (nodes_at == std::string::npos) return false;
+
+    auto find = [&](FlatKind kind) {
+        for (FlatIndex i = 0; i < ast.size(); i++) {
+            if (ast.kind(i) == kind) return i;
+        }
+        return NO_NODE;
+    };
+    FlatIndex binary = find(FlatKind::_binary);
+    FlatIndex block = find(FlatKind::_block);
+    FlatIndex function = find(FlatKind::_function);
+    FlatIndex extra_count = ast.node(function).b + ast.node(function).c + 3;
+
+    struct Corruption {
+        FlatIndex node;
+        std::size_t field;
+        FlatIndex value;
+    };
+    const Corruption corruptions[] = {
+        {binary, offsetof(FlatNode, a), binary},
+        {binary, offsetof(FlatNode, b), static_cast<FlatIndex>(ast.size())},
+        {block, offsetof(FlatNode, c), 0xfffffff0},
+        {function, offsetof(FlatNode, b), extra_count - ast.node(function).c - 2},
+    };
+
+    bool missed = true;
+    for (const Corruption& corruption : corruptions) {
+        std::string corrupt = file;
+        std::memcpy(corrupt.data() + nodes_at + corruption.node * sizeof(FlatNode) + corruption.field, &corruption.value, sizeof(FlatIndex));
+
+        std::ofstream out(AstCache::pathFor(path), std::ios::binary | std::ios::trunc);
+        out.write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+        out.close();
+
+        missed = missed && !cache.load(content);
+    }
+
+    std::remove(AstCache::pathFor(path).c_str());
+    return missed;
+}
+
+template <typename Run>
+double bestMillis(int iterations, Run run) {
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds * 1e3;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    if (!checkCorruptOperands()) {
+        std::cerr << "a cache file with corrupt node operands was loaded" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string path = "ast_cache_bench.gaz";
+    {
+        CorpusOptions options;
+        options.size = megabytes * 1024 * 1024;
+        std::string source = CorpusGenerator(options).generate();
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(source.data(), static_cast<std::streamsize>(source.size()));
+    }
+
+    SourceFile source;
+    if (!source.open(path)) {
+        std::cerr << "could not open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    AstCache cache(AstCache::pathFor(path));
+    FlatAst parsed;
+    std::optional<FlatAst> loaded;
+
+    double cold = bestMillis(iterations, [&] {
+        Tokenizer tokenizer(source.content());
+        Parser parser(tokenizer.tokenize());
+        parsed = FlatAst(parser.parse());
+    });
+
+    if (!cache.save(source.content(), parsed)) {
+        std::cerr << "could not write " << AstCache::pathFor(path) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double warm = bestMillis(iterations, [&] {
+        loaded = cache.load(source.content());
+    });
+
+    bool same = loaded && sameAst(parsed, *loaded);
+    std::remove(AstCache::pathFor(path).c_str());
+    std::remove(path.c_str());
+
+    if (!same) {
+        std::cerr << "loaded AST differs from parsed AST" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "input:      " << megabytes << " MB, " << parsed.size() << " nodes, " << parsed.bytes() / 1024 << " KB" << std::endl;
+    std::cout << "cold parse: " << cold << " ms" << std::endl;
+    std::cout << "warm cache: " << warm << " ms" << std::endl;
+    std::cout << "speedup:    " << cold / warm << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
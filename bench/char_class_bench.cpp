@@ -0,0 +1,123 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "../src/tokenization.hpp"
+
+/*
+    Character dispatch microbenchmark.
+
+    Classifies every byte of a generated program the way the tokenizer's
+    main loop does (word, whitespace or special, plus the two character
+    punctuator check on specials) once with the comparison chains the
+    tokenizer used to have and once with CHAR_CLASS_TABLE and
+    DOUBLE_CHAR_TABLE, and reports the time per byte of each.
+
+    usage: char_class_bench.o [size in MB] [iterations]
+*/
+
+// the dispatch from before the tables, kept here as the baseline
+bool chainIsSpecial(char c) {
+    return c == ';' || c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == '"' || c == '\'' || c == '=' || c == '.' || c == ',' || c == '<' || c == '>' || c == '+' || c == '-' || c == '*' || c == '/' || c == '|' || c == '%' || c == '&' || c == '^';
+}
+
+bool chainIsDoubleChar(char c, char next) {
+    return (c == '-' && next == '>') ||
+        (c == '<' && next == '-') ||
+        (c == '/' && next == '/') ||
+        (c == '/' && next == '*') ||
+        (c == '>' && next == '=') ||
+        (c == '<' && next == '=') ||
+        (c == '<' && next == '<') ||
+        (c == '>' && next == '>') ||
+        (c == '.' && next == '.') ||
+        (c == '*' && next == '*') ||
+        (c == '!' && next == '=') ||
+        (c == '|' && next == '|') ||
+        (c == '=' && next == '=');
+}
+
+std::size_t chainDispatch(std::string_view source) {
+    std::size_t checksum = 0;
+    for (std::size_t i = 0; i + 1 < source.size(); i++) {
+        char c = source[i];
+        if (c == EOF) {
+            checksum += 7;
+        } else if (std::isspace(c)) {
+            checksum += 1;
+        } else if (chainIsSpecial(c)) {
+            checksum += chainIsDoubleChar(c, source[i + 1]) ? 5 : 3;
+        }
+    }
+    return checksum;
+}
+
+std::size_t tableDispatch(std::string_view source) {
+    std::size_t checksum = 0;
+    for (std::size_t i = 0; i + 1 < source.size(); i++) {
+        switch (charClass(source[i])) {
+            case CHAR_END: checksum += 7; break;
+            case CHAR_WHITESPACE: checksum += 1; break;
+            case CHAR_SPECIAL: checksum += isDoubleCharPair(source[i], source[i + 1]) ? 5 : 3; break;
+            case CHAR_WORD: break;
+        }
+    }
+    return checksum;
+}
+
+std::string makeSource(std::size_t target_size) {
+    static const char* lines[] = {
+        "var integer total = (alpha + beta) * gamma - 12;\n",
+        "if (index <= length_of) { result = result ** 2; } else { result = -result; }\n",
+        "loop while (count < 100) { count = count + 1; } // bump the counter\n",
+        "procedure step(var integer x, integer y) returns integer { return x .. y; }\n",
+        "\"total so far\" -> std_output; value <- std_input;\n",
+    };
+    const std::size_t line_count = sizeof(lines) / sizeof(lines[0]);
+
+    std::string source;
+    source.reserve(target_size + 128);
+    for (std::size_t i = 0; source.size() < target_size; i++) {
+        source += lines[(i * 7) % line_count];
+    }
+    return source;
+}
+
+template <typename Dispatch>
+double bestNanosPerByte(const std::string& source, int iterations, Dispatch dispatch, std::size_t& checksum) {
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        checksum = dispatch(source);
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds * 1e9 / static_cast<double>(source.size());
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 16;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::string source = makeSource(megabytes * 1024 * 1024);
+
+    std::size_t chain_checksum = 0;
+    std::size_t table_checksum = 0;
+    double chain = bestNanosPerByte(source, iterations, chainDispatch, chain_checksum);
+    double table = bestNanosPerByte(source, iterations, tableDispatch, table_checksum);
+
+    if (chain_checksum != table_checksum) {
+        std::cerr << "dispatch mismatch: " << chain_checksum << " != " << table_checksum << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "input:      " << megabytes << " MB" << std::endl;
+    std::cout << "chains:     " << chain << " ns/byte" << std::endl;
+    std::cout << "tables:     " << table << " ns/byte" << std::endl;
+    std::cout << "speedup:    " << chain / table << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+    Deterministic generator of synthetic Gazprea programs for the
+    benchmarks.
+
+    Programs are built from the constructs in src/main.gaz that the parser
+    accepts: global declarations and assignments, one line and block bodied
+    functions, procedures, if/else chains, `loop while` and `loop ... while`
+    loops, calls, returns and streams to std_output. The same options and
+    seed always give the same program.
+
+    * size: bytes to generate, the last top level item may run a little over
+    * nesting: deepest level of if/loop blocks inside a function body
+    * identifiers: share of expression operands that are names rather than literals
+    * comments: chance of a line or block comment before each statement
+    * integers .. booleans: relative weights of the literal kinds
+*/
+struct CorpusOptions {
+    std::size_t size = 4 * 1024 * 1024;
+    int nesting = 3;
+    double identifiers = 0.6;
+    double comments = 0.1;
+    unsigned int integers = 4;
+    unsigned int reals = 1;
+    unsigned int strings = 1;
+    unsigned int characters = 1;
+    unsigned int booleans = 1;
+    uint32_t seed = 12345;
+};
+
+class CorpusGenerator {
+private:
+    CorpusOptions m_options;
+    std::string m_source;
+    uint32_t m_seed;
+    unsigned int m_functions = 0;
+    unsigned int m_procedures = 0;
+    unsigned int m_globals = 0;
+
+    // simple LCG so the corpus is identical on every run and platform
+    uint32_t next() {
+        m_seed = m_seed * 1103515245u + 12345u;
+        return (m_seed >> 16) & 0x7fff;
+    }
+
+    bool chance(double p) {
+        return next() < p * 0x8000;
+    }
+
+    unsigned int pick(unsigned int count) {
+        return next() % count;
+    }
+
+    std::string indent(int depth) {
+        return std::string(depth * 4, ' ');
+    }
+
+    std::string name() {
+        static const char* stems[] = {
+            "alpha", "beta", "gamma", "delta", "count", "total", "index", "value",
+            "buffer", "result", "offset", "length_of", "row", "column", "acc", "tmp"
+        };
+        return std::string(stems[pick(16)]) + "_" + std::to_string(pick(512));
+    }
+
+    std::string literal() {
+        static const char* words[] = {"total so far", "done", "row\\tcolumn", "value: ", "line\\n", "Hello, "};
+        static const char* characters[] = {"'a'", "'z'", "'\\n'", "'\\t'", "'0'"};
+
+        unsigned int total = m_options.integers + m_options.reals + m_options.strings + m_options.characters + m_options.booleans;
+        unsigned int roll = total ? pick(total) : 0;
+
+        if (roll < m_options.integers || total == 0) return std::to_string(pick(1000));
+        roll -= m_options.integers;
+        if (roll < m_options.reals) return std::to_string(pick(100)) + "." + std::to_string(pick(100));
+        roll -= m_options.reals;
+        if (roll < m_options.strings) return "\"" + std::string(words[pick(6)]) + "\"";
+        roll -= m_options.strings;
+        if (roll < m_options.characters) return characters[pick(5)];
+        return chance(0.5) ? "true" : "false";
+    }
+
+    std::string call() {
+        std::string text = "f_" + std::to_string(m_functions ? pick(m_functions) : 0) + "(";
+        unsigned int arguments = 1 + pick(3);
+        for (unsigned int i = 0; i < arguments; i++) {
+            // the lexer reads `-` after `,` as binary, so only the first argument may be negated
+            text += (i ? ", " : "") + operand(1, i == 0);
+        }
+        return text + ")";
+    }
+
+    std::string operand(int depth, bool negate = true) {
+        if (depth < 3 && chance(0.08)) return "(" + expression(depth + 1) + ")";
+        if (depth < 3 && chance(0.05)) return call();
+        if (negate && chance(0.05)) return "-" + name();
+        return chance(m_options.identifiers) ? name() : literal();
+    }
+
+    std::string expression(int depth = 0, bool negate = true) {
+        static const char* operators[] = {" + ", " - ", " * ", " / ", " % ", " < ", " == ", " and ", " or "};
+
+        std::string text = operand(depth, negate);
+        unsigned int terms = pick(4);
+        for (unsigned int i = 0; i < terms; i++) {
+            text += operators[pick(9)] + operand(depth);
+        }
+        return text;
+    }
+
+    void comment(int depth) {
+        if (!chance(m_options.comments)) return;
+
+        if (chance(0.7)) {
+            m_source += indent(depth) + "// keep " + name() + " in range before the next pass\n";
+        } else {
+            m_source += indent(depth) + "/*\n" + indent(depth) + "    " + name() + " and " + name() + " are updated together,\n" +
+                indent(depth) + "    see the loop below.\n" + indent(depth) + "*/\n";
+        }
+    }
+
+    void statement(int depth, bool in_loop) {
+        comment(depth);
+        std::string pad = indent(depth);
+        unsigned int kind = pick(in_loop ? 9 : 8);
+
+        if (kind <= 1) {
+            m_source += pad + "var integer " + name() + " = " + expression() + ";\n";
+        } else if (kind <= 3) {
+            m_source += pad + name() + " = " + expression() + ";\n";
+        } else if (kind == 4) {
+            m_source += pad + name() + " -> std_output;\n";
+        } else if (kind == 5) {
+            m_source += pad + "call " + call() + ";\n";
+        } else if (kind == 6 && depth <= m_options.nesting) {
+            m_source += pad + "if (" + expression() + ")\n";
+            block(depth, in_loop);
+            if (chance(0.5)) {
+                m_source += pad + "else\n";
+                block(depth, in_loop);
+            }
+        } else if (kind == 7 && depth <= m_options.nesting) {
+            if (chance(0.7)) {
+                m_source += pad + "loop while (" + expression() + ")\n";
+                block(depth, true);
+            } else {
+                m_source += pad + "loop\n";
+                block(depth, true, false);
+                // nor after `while`
+                m_source += " while " + expression(0, false) + ";\n";
+            }
+        } else if (kind == 8) {
+            m_source += pad + "break;\n";
+        } else {
+            m_source += pad + name() + " = " + name() + " + 1;\n";
+        }
+    }
+
+    // `{ ... }` at `depth`, the closing brace ends the line unless `newline` is false
+    void block(int depth, bool in_loop, bool newline = true) {
+        m_source += indent(depth) + "{\n";
+        unsigned int statements = 2 + pick(4);
+        for (unsigned int i = 0; i < statements; i++) {
+            statement(depth + 1, in_loop);
+        }
+        m_source += indent(depth) + (newline ? "}\n" : "}");
+    }
+
+    void topLevel() {
+        comment(0);
+        unsigned int kind = pick(10);
+
+        if (kind <= 2) {
+            m_source += (chance(0.3) ? "const integer " : "var integer ") + std::string("g_") + std::to_string(m_globals++) + " = " + expression() + ";\n";
+        } else if (kind == 3) {
+            m_source += "function f_" + std::to_string(m_functions++) + "(integer a, integer b) returns integer = " + expression() + ";\n";
+        } else if (kind <= 6) {
+            m_source += "function f_" + std::to_string(m_functions++) + "(integer a, integer b) returns integer\n";
+            m_source += "{\n";
+            unsigned int statements = 2 + pick(5);
+            for (unsigned int i = 0; i < statements; i++) {
+                statement(1, false);
+            }
+            m_source += "    return " + expression() + ";\n}\n";
+        } else if (kind <= 8) {
+            m_source += "procedure p_" + std::to_string(m_procedures++) + "(var integer x)\n";
+            block(0, false);
+        } else {
+            statement(0, false);
+        }
+        m_source += "\n";
+    }
+
+public:
+    explicit CorpusGenerator(CorpusOptions options) : m_options(options), m_seed(options.seed) {}
+
+    std::string generate() {
+        m_source.clear();
+        m_source.reserve(m_options.size + 4096);
+        while (m_source.size() < m_options.size) {
+            topLevel();
+        }
+        return m_source;
+    }
+};
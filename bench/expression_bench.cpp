@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/parser.hpp"
+
+/*
+    Expression parsing benchmark.
+
+    Builds a program of declarations whose initializers are long arithmetic
+    and comparison chains, `var integer v_0 = a * 3 + b - 7 / c < d ...`, so
+    nearly every other token goes through the operator loop in
+    Parser::parseExpression(). Tokens are lexed once, only parse() is timed.
+
+    usage: expression_bench.o [size in MB] [operands per chain] [iterations]
+*/
+
+std::string makeSource(std::size_t target_size, int operands) {
+    static const char* operators[] = {" + ", " * ", " - ", " / ", " < ", " == ", " and ", " or ", " >= "};
+    static const char* names[] = {"alpha", "beta", "gamma", "delta", "count", "total"};
+    const std::size_t operator_count = sizeof(operators) / sizeof(operators[0]);
+
+    std::string source;
+    source.reserve(target_size + 4096);
+    uint32_t seed = 12345;
+    for (std::size_t line = 0; source.size() < target_size; line++) {
+        source += "var integer v_" + std::to_string(line) + " = ";
+        for (int i = 0; i < operands; i++) {
+            seed = seed * 1103515245u + 12345u;
+            if (i) source += operators[(seed >> 16) % operator_count];
+            source += (seed >> 8) & 1 ? names[(seed >> 20) % 6] : std::to_string((seed >> 12) % 1000);
+        }
+        source += ";\n";
+    }
+    return source;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 4;
+    int operands = argc > 2 ? std::stoi(argv[2]) : 64;
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+
+    std::string source = makeSource(megabytes * 1024 * 1024, operands);
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    // one copy per run made up front, the parser takes its tokens over
+    std::vector<std::vector<Token>> inputs(iterations, tokens);
+
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            Parser parser(std::move(inputs[i]));
+            parser.parse();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+
+    std::cout << "input:  " << megabytes << " MB, " << tokens.size() << " tokens, " << operands << " operands per chain" << std::endl;
+    std::cout << "parse:  " << best_seconds * 1e3 << " ms" << std::endl;
+    std::cout << "tokens: " << static_cast<double>(tokens.size()) / best_seconds / 1e6 << " M/s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../src/tokenization.hpp"
+#include "../src/parser.hpp"
+#include "corpus.hpp"
+
+/*
+    Front-end throughput benchmark.
+
+    Generates a program with CorpusGenerator and measures
+    `Tokenizer::tokenize()` over it and `Parser::parse()` over the tokens.
+    The result is printed as one JSON object so runs can be stored and
+    compared over time.
+
+    Times are the best of `--iterations` runs. Allocations and peak RSS come
+    from the first run of each phase. Allocations are counted by replacing
+    the global operator new. Peak RSS is the kernel's high water mark, reset
+    before each phase where /proc/self/clear_refs allows it.
+
+    usage: frontend_bench.o [--size MB] [--nesting N] [--identifiers 0..1]
+        [--comments 0..1] [--literals int,real,string,char,bool] [--seed N]
+        [--iterations N] [--emit file]
+
+    --emit writes the generated program to `file` instead of measuring.
+*/
+
+static std::atomic<std::size_t> g_allocations{0};
+static std::atomic<std::size_t> g_allocated_bytes{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// lets the next peakRssKb() report the peak of what runs after this call only
+void resetPeakRss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+long peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::stol(line.substr(6));
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+struct Phase {
+    double best_seconds = 0;
+    std::size_t allocations = 0;
+    std::size_t allocated_bytes = 0;
+    long peak_rss_kb = 0;
+};
+
+template <typename Run>
+Phase measure(int iterations, Run run) {
+    Phase phase;
+    for (int i = 0; i < iterations; i++) {
+        if (i == 0) resetPeakRss();
+        std::size_t allocations = g_allocations.load();
+        std::size_t allocated_bytes = g_allocated_bytes.load();
+
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (i == 0) {
+            phase.allocations = g_allocations.load() - allocations;
+            phase.allocated_bytes = g_allocated_bytes.load() - allocated_bytes;
+            phase.peak_rss_kb = peakRssKb();
+        }
+        if (i == 0 || seconds < phase.best_seconds) phase.best_seconds = seconds;
+    }
+    return phase;
+}
+
+void printPhase(const char* name, const Phase& phase, std::size_t bytes, std::size_t tokens, bool last) {
+    double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cout << "  \"" << name << "\": {\n"
+        << "    \"seconds\": " << phase.best_seconds << ",\n"
+        << "    \"tokens_per_second\": " << static_cast<double>(tokens) / phase.best_seconds << ",\n"
+        << "    \"mb_per_second\": " << mb / phase.best_seconds << ",\n"
+        << "    \"allocations\": " << phase.allocations << ",\n"
+        << "    \"allocated_bytes\": " << phase.allocated_bytes << ",\n"
+        << "    \"peak_rss_kb\": " << phase.peak_rss_kb << "\n"
+        << "  }" << (last ? "\n" : ",\n");
+}
+
+int main(int argc, char* argv[]) {
+    CorpusOptions options;
+    int iterations = 5;
+    std::string emit;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+
+        if (flag == "--size") {
+            options.size = static_cast<std::size_t>(std::stod(value) * 1024 * 1024);
+        } else if (flag == "--nesting") {
+            options.nesting = std::stoi(value);
+        } else if (flag == "--identifiers") {
+            options.identifiers = std::stod(value);
+        } else if (flag == "--comments") {
+            options.comments = std::stod(value);
+        } else if (flag == "--literals") {
+            char comma;
+            std::istringstream weights(value);
+            weights >> options.integers >> comma >> options.reals >> comma >> options.strings >> comma >> options.characters >> comma >> options.booleans;
+        } else if (flag == "--seed") {
+            options.seed = static_cast<uint32_t>(std::stoul(value));
+        } else if (flag == "--iterations") {
+            iterations = std::max(1, std::stoi(value));
+        } else if (flag == "--emit") {
+            emit = value;
+        } else {
+            std::cerr << "unknown option " << flag << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::string source = CorpusGenerator(options).generate();
+
+    if (!emit.empty()) {
+        std::ofstream file(emit, std::ios::binary | std::ios::trunc);
+        file.write(source.data(), static_cast<std::streamsize>(source.size()));
+        return file ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::vector<Token> tokens;
+    Phase tokenize = measure(iterations, [&] {
+        Tokenizer tokenizer(source);
+        tokens = tokenizer.tokenize();
+    });
+
+    // the parser takes over its tokens, so every run gets its own copy, made before timing starts
+    std::vector<std::vector<Token>> inputs(iterations, tokens);
+    std::size_t run = 0;
+
+    // includes freeing the AST, the parser's arena releases it when the parser goes out of scope
+    Phase parse = measure(iterations, [&] {
+        Parser parser(std::move(inputs[run++]));
+        parser.parse();
+    });
+
+    std::size_t lines = static_cast<std::size_t>(std::count(source.begin(), source.end(), '\n'));
+    std::cout << "{\n"
+        << "  \"corpus\": {\n"
+        << "    \"bytes\": " << source.size() << ",\n"
+        << "    \"lines\": " << lines << ",\n"
+        << "    \"tokens\": " << tokens.size() << ",\n"
+        << "    \"seed\": " << options.seed << ",\n"
+        << "    \"nesting\": " << options.nesting << ",\n"
+        << "    \"identifiers\": " << options.identifiers << ",\n"
+        << "    \"comments\": " << options.comments << ",\n"
+        << "    \"literals\": {\"integer\": " << options.integers << ", \"real\": " << options.reals << ", \"string\": " << options.strings
+            << ", \"character\": " << options.characters << ", \"boolean\": " << options.booleans << "}\n"
+        << "  },\n"
+        << "  \"iterations\": " << iterations << ",\n";
+    printPhase("tokenize", tokenize, source.size(), tokens.size(), false);
+    printPhase("parse", parse, source.size(), tokens.size(), true);
+    std::cout << "}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
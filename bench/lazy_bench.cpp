@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../src/parser.hpp"
+
+/*
+    Lazy function body benchmark.
+
+    The program is a library of `functions` functions, each with a body of
+    loops, ifs and arithmetic, and a few top-level statements that call the
+    first of them. Function i calls function i + 1 up to `reachable`, so
+    that many bodies are reachable and the rest are never called. It is
+    parsed eagerly and with setLazyBodies(true), tokens are lexed once and
+    only parsing is timed. Allocations, counted by replacing the global
+    operator new, stand in for AST memory.
+
+    usage: lazy_bench.o [functions] [reachable] [iterations]
+*/
+
+static std::atomic<std::size_t> g_allocated_bytes{0};
+
+void* operator new(std::size_t size) {
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+std::string library(int functions, int reachable) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        std::string next = i + 1 < reachable ? "lib_" + std::to_string(i + 1) + "(x - 1)" : "0";
+
+        source += "function lib_" + std::to_string(i) + "(integer a) returns integer {\n";
+        source += "    var integer x = a * 2 + " + std::to_string(i) + ";\n";
+        source += "    loop while (x < 100) { x = x + 3; if (x == 50) { break; } }\n";
+        source += "    if (x > 10) { x = x - (x / 2) * 3; } else { x = -x + 7; }\n";
+        source += "    loop { x = x - 1; if (x < 0) { break; } }\n";
+        source += "    return x + " + next + ";\n";
+        source += "}\n";
+    }
+
+    source += "var integer result = lib_0(3);\n";
+    source += "result -> std_output;\n";
+    return source;
+}
+
+struct Run {
+    double seconds = 0;
+    std::size_t bytes = 0;
+    std::size_t bodies = 0;
+};
+
+Run parseLibrary(const std::vector<Token>& tokens, bool lazy, int iterations) {
+    Run best;
+    for (int i = 0; i < iterations; i++) {
+        // the parser takes its tokens over, the copy is not timed
+        std::vector<Token> input = tokens;
+
+        std::size_t bytes = g_allocated_bytes.load();
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(std::move(input));
+        parser.setLazyBodies(lazy);
+        NodeProgram* program = parser.parse();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (i == 0) {
+            best.bytes = g_allocated_bytes.load() - bytes;
+            for (NodeProgramElement* element : program->_elements) {
+                auto* function = std::get_if<NodeFunctionDecleration*>(&element->_element);
+                best.bodies += function && ((*function)->_statement || (*function)->_expression);
+            }
+        }
+        if (i == 0 || seconds < best.seconds) best.seconds = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int functions = argc > 1 ? std::stoi(argv[1]) : 20000;
+    int reachable = argc > 2 ? std::stoi(argv[2]) : 100;
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+
+    std::string source = library(functions, reachable);
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    std::cout << "input: " << functions << " functions, " << reachable << " reachable, " << tokens.size() << " tokens" << std::endl;
+
+    Run eager = parseLibrary(tokens, false, iterations);
+    Run lazy = parseLibrary(tokens, true, iterations);
+
+    std::cout << "eager: " << eager.seconds * 1e3 << " ms, " << eager.bytes / 1024 << " KB allocated, "
+        << eager.bodies << " bodies parsed" << std::endl;
+    std::cout << "lazy:  " << lazy.seconds * 1e3 << " ms, " << lazy.bytes / 1024 << " KB allocated, "
+        << lazy.bodies << " bodies parsed, " << eager.seconds / lazy.seconds << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/tokenization.hpp"
+
+/*
+    Lexer throughput microbenchmark.
+
+    Builds two large programs in memory and reports how many megabytes per
+    second `Tokenizer::tokenize()` gets through on each:
+
+    * identifier-heavy, every statement is a declaration whose initializer
+      references several previously declared names
+    * comment-heavy, the same statements under block and line comments with
+      indented, string-carrying bodies
+
+    The identifier-heavy program is also run through tokenizeParallel() with
+    a growing number of threads, and its first 50k lines are used to compare
+    re-tokenizing after a one character edit against relex().
+
+    Before measuring, names longer than a SymbolTable block are interned
+    between short ones, and a program with string literals of that size is
+    lexed, every name and literal must read back unchanged.
+
+    usage: lexer_bench.o [size in MB] [iterations]
+*/
+
+std::string makeIdentifierHeavySource(std::size_t target_size) {
+    static const char* stems[] = {
+        "alpha", "beta", "gamma", "delta", "count", "total", "index", "value",
+        "buffer", "result", "offset", "length_of", "row", "column", "acc", "tmp"
+    };
+    const std::size_t stem_count = sizeof(stems) / sizeof(stems[0]);
+
+    std::string source;
+    source.reserve(target_size + 128);
+
+    // simple LCG so the corpus is identical on every run
+    unsigned int seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    auto name = [&](unsigned int n) {
+        return std::string(stems[n % stem_count]) + "_" + std::to_string(n % 4096);
+    };
+
+    unsigned int declared = 0;
+    while (source.size() < target_size) {
+        source += "var integer " + name(declared) + " = " + name(next()) + " + " + name(next()) + " * " + name(next()) + ";\n";
+        if (declared % 8 == 0) {
+            source += "if (" + name(next()) + " < " + name(next()) + ") { " + name(declared) + " = " + name(next()) + "; }\n";
+        }
+        declared++;
+    }
+
+    return source;
+}
+
+std::string makeCommentHeavySource(std::size_t target_size) {
+    std::string source;
+    source.reserve(target_size + 512);
+
+    unsigned int n = 0;
+    while (source.size() < target_size) {
+        source += "/*\n"
+            "    Running total for block " + std::to_string(n) + ", kept separately so the\n"
+            "    checks below can compare against the value from the previous pass.\n"
+            "*/\n";
+        source += "var integer total_" + std::to_string(n) + " = 0; // reset on every pass\n";
+        source += "        // walk the current range and accumulate the values we care about\n";
+        source += "        total_" + std::to_string(n) + " = total_" + std::to_string(n) + " + " + std::to_string(n * 7) + ";\n";
+        source += "        \"value of the accumulated total after this block\" -> std_output;\n\n";
+        n++;
+    }
+
+    return source;
+}
+
+void runCorpus(const std::string& name, const std::string& source, int iterations) {
+    std::size_t token_count = 0;
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+
+        Tokenizer tokenizer(source);
+        std::vector<Token> tokens = tokenizer.tokenize();
+
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+
+        token_count = tokens.size();
+    }
+
+    double mb = static_cast<double>(source.size()) / (1024.0 * 1024.0);
+    std::cout << name << std::endl;
+    std::cout << "input:      " << mb << " MB, " << token_count << " tokens" << std::endl;
+    std::cout << "best time:  " << best_seconds * 1000.0 << " ms" << std::endl;
+    std::cout << "throughput: " << mb / best_seconds << " MB/s" << std::endl;
+}
+
+// tokenizeParallel() throughput for 1, 2, 4, ... threads up to the number of cores
+void runParallel(const std::string& name, const std::string& source, int iterations) {
+    double mb = static_cast<double>(source.size()) / (1024.0 * 1024.0);
+    std::cout << name << " (tokenizeParallel)" << std::endl;
+
+    for (unsigned int threads = 1; threads <= ThreadPool::defaultThreadCount(); threads *= 2) {
+        double best_seconds = 0;
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+
+            Tokenizer tokenizer(source);
+            std::vector<Token> tokens = tokenizer.tokenizeParallel(threads);
+
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+        }
+
+        std::cout << "threads " << threads << ":  " << mb / best_seconds << " MB/s" << std::endl;
+    }
+}
+
+// full re-tokenization against relex() for single character edits spread over a 50k line file
+void runIncremental(const std::string& name, const std::string& corpus, int iterations) {
+    std::size_t end = 0;
+    for (int line = 0; line < 50000 && end != std::string::npos; line++) {
+        end = corpus.find('\n', end + 1);
+    }
+    std::string source = corpus.substr(0, end == std::string::npos ? corpus.size() : end + 1);
+
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    double full_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        Tokenizer full(source);
+        full.tokenize();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < full_seconds) full_seconds = seconds;
+    }
+
+    // type a `z` into an identifier and delete it again, at 100 places through the file
+    std::string inserted = source;
+    double relex_seconds = 0;
+    int edits = 0;
+    for (int i = 0; i < 100; i++) {
+        std::size_t offset = source.find('_', source.size() / 100 * i);
+        if (offset == std::string::npos) break;
+
+        inserted = source.substr(0, offset) + "z" + source.substr(offset);
+
+        auto start = std::chrono::steady_clock::now();
+        tokenizer.relex(inserted, tokens, TextEdit{offset, 0, std::string_view(inserted).substr(offset, 1)});
+        tokenizer.relex(source, tokens, TextEdit{offset, 1, ""});
+        relex_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        edits += 2;
+    }
+
+    std::cout << name << " (50k lines, " << tokens.size() << " tokens)" << std::endl;
+    std::cout << "tokenize():  " << full_seconds * 1000.0 << " ms per edit" << std::endl;
+    std::cout << "relex():     " << relex_seconds * 1000.0 / edits << " ms per edit" << std::endl;
+}
+
+// names over the 64 KB block size mixed with short ones, each must read back as it was stored
+bool checkLongNames() {
+    SymbolTable table;
+    std::vector<std::string> names = {std::string(70000, 'a'), "hello", std::string(200000, 'b'), "world", std::string(65536, 'c'), "again"};
+
+    std::vector<SymbolId> ids;
+    for (const std::string& name : names) ids.push_back(table.intern(name));
+
+    for (std::size_t i = 0; i < names.size(); i++) {
+        if (table.name(ids[i]) != names[i] || table.intern(names[i]) != ids[i]) return false;
+    }
+    return true;
+}
+
+// string literals over the block size followed by short ones, lexed and decoded like any other
+bool checkLongLiterals() {
+    std::vector<std::string> literals = {std::string(70000, 'x'), "hello", std::string(130000, 'y'), "world"};
+
+    std::string source;
+    for (const std::string& literal : literals) source += "\"" + literal + "\" -> std_output;\n";
+
+    Tokenizer tokenizer(source);
+    std::vector<std::string_view> texts;
+    for (const Token& token : tokenizer.tokenize()) {
+        if (token.getTokenType() == TokenType::_text) texts.push_back(token.getStrValue());
+    }
+
+    if (texts.size() != literals.size()) return false;
+    for (std::size_t i = 0; i < literals.size(); i++) {
+        if (texts[i] != literals[i]) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 4;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    if (!checkLongNames()) {
+        std::cerr << "SymbolTable lost a name longer than a block" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!checkLongLiterals()) {
+        std::cerr << "a string literal longer than a block was not lexed back unchanged" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string identifier_heavy = makeIdentifierHeavySource(megabytes * 1024 * 1024);
+    runCorpus("identifier-heavy", identifier_heavy, iterations);
+    runParallel("identifier-heavy", identifier_heavy, iterations);
+    runIncremental("identifier-heavy", identifier_heavy, iterations);
+    runCorpus("comment-heavy", makeCommentHeavySource(megabytes * 1024 * 1024), iterations);
+
+    return EXIT_SUCCESS;
+}
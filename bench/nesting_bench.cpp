@@ -0,0 +1,179 @@
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/generator.hpp"
+
+/*
+    Deep nesting benchmark.
+
+    Each case is one construct nested `depth` levels deep, `((((x))))`,
+    `not not not x`, `x ^ x ^ x` (right associative, every rhs is a new
+    level), `x + x + x` (left associative, every lhs is), `x.a.a.a` as a
+    value and as an assignment target, `f(f(f(x)))`,
+    `(x, (x, x))`, `[x, [x, x]]`, `{ { { } } }`, `if (x) if (x) ...` and
+    `loop loop ...`. The parser keeps these on heap-backed stacks, so none
+    of them may overflow the call stack. Every case is also parsed at half
+    the depth: parse time is linear when the ns per token column stays flat
+    between the two.
+
+    `tuple(tuple(...))` and `vector<vector<...>>` types still parse
+    recursively. Deeper than Parser::MAX_TYPE_DEPTH they must be a parse
+    error, and they are measured at that depth instead.
+
+    The full depth program is then flattened and generated. FlatAst and
+    the generator's expression walk are iterative too, statements are
+    generated recursively and nesting them too deep is an error. Cases the
+    generator does not support must fail with the expected error, not a
+    crash.
+
+    usage: nesting_bench.o [depth] [iterations]
+*/
+
+struct NestingCase {
+    const char* name;
+    std::function<std::string(int)> make;
+    // nullptr when the case generates, else the error the generator reports
+    const char* generate_error;
+    // 0 when any depth parses, else deeper nesting is a parse error and the case runs at this depth
+    int max_depth = 0;
+};
+
+// declares what the cases use
+const std::string PRELUDE = "function f(integer a) returns integer { return a; }\nvar integer x = 1;\n";
+
+std::string repeat(const std::string& text, int count) {
+    std::string result;
+    result.reserve(text.size() * count);
+    for (int i = 0; i < count; i++) result += text;
+    return result;
+}
+
+const char* NESTED_STATEMENTS = "Statements nested more than";
+// what the parser reports past a case's max_depth
+const char* NESTED_TOO_DEEP = "nested more than";
+
+const NestingCase CASES[] = {
+    {"parens", [](int depth) { return "var integer v = " + repeat("(", depth) + "x" + repeat(")", depth) + ";\n"; }, nullptr},
+    {"prefix", [](int depth) { return "var boolean v = " + repeat("not ", depth) + "x;\n"; }, nullptr},
+    {"chain", [](int depth) { return "var integer v = x" + repeat(" ^ x", depth) + ";\n"; }, "Invalid binary expression"},
+    {"sum", [](int depth) { return "var integer v = x" + repeat(" + x", depth) + ";\n"; }, nullptr},
+    {"members", [](int depth) { return "var integer v = x" + repeat(".a", depth) + ";\n"; }, "member access"},
+    {"member assign", [](int depth) { return "x" + repeat(".a", depth) + " = 1;\n"; }, nullptr},
+    {"calls", [](int depth) { return "var integer v = " + repeat("f(", depth) + "x" + repeat(")", depth) + ";\n"; }, nullptr},
+    {"tuples", [](int depth) { return "var integer v = " + repeat("(x, ", depth) + "x" + repeat(")", depth) + ";\n"; }, "Invalid expression variant"},
+    {"lists", [](int depth) { return "var integer v = " + repeat("[x, ", depth) + "x" + repeat("]", depth) + ";\n"; }, "Invalid expression variant"},
+    {"tuple types", [](int depth) { return repeat("tuple(", depth) + "integer, integer" + repeat(")", depth) + " v = x;\n"; }, nullptr, Parser::MAX_TYPE_DEPTH},
+    {"vector types", [](int depth) { return repeat("vector<", depth) + "integer" + repeat(" >", depth) + " v = x;\n"; }, nullptr, Parser::MAX_TYPE_DEPTH},
+    {"blocks", [](int depth) { return repeat("{ ", depth) + "x = 1;" + repeat(" }", depth) + "\n"; }, NESTED_STATEMENTS},
+    {"ifs", [](int depth) { return repeat("if (x) ", depth) + "x = 1;\n"; }, NESTED_STATEMENTS},
+    {"loops", [](int depth) { return repeat("loop while (x) ", depth) + "break;\n"; }, NESTED_STATEMENTS},
+};
+
+// best of `iterations` parses of `source`, in seconds
+double parseSeconds(const std::string& source, int iterations, std::size_t& token_count) {
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+    token_count = tokens.size();
+
+    // one copy per run made up front, the parser takes its tokens over
+    std::vector<std::vector<Token>> inputs(iterations, tokens);
+
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            Parser parser(std::move(inputs[i]));
+            parser.parse();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds;
+}
+
+// what parsing `source` threw, empty when it parsed
+std::string parseError(const std::string& source) {
+    Tokenizer tokenizer(source);
+    try {
+        Parser parser(tokenizer.tokenize());
+        parser.parse();
+    } catch (const std::runtime_error& error) {
+        return error.what();
+    }
+    return "";
+}
+
+struct Generated {
+    double flatten_seconds = 0;
+    double generate_seconds = 0;
+    // what the generator threw, empty when it wrote output.s
+    std::string error;
+};
+
+// flattens and generates `source` once, the Generator writes output.s to the working directory
+Generated generate(const std::string& source) {
+    Tokenizer tokenizer(source);
+    Parser parser(tokenizer.tokenize());
+    NodeProgram* program = parser.parse();
+
+    Generated result;
+    auto start = std::chrono::steady_clock::now();
+    FlatAst ast(program);
+    auto flattened = std::chrono::steady_clock::now();
+    result.flatten_seconds = std::chrono::duration<double>(flattened - start).count();
+
+    try {
+        Generator generator(std::move(ast));
+        generator.generate();
+    } catch (const std::runtime_error& error) {
+        result.error = error.what();
+    }
+    result.generate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - flattened).count();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int depth = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::cout << "depth: " << depth << std::endl;
+    for (const NestingCase& nesting : CASES) {
+        int case_depth = depth;
+        if (nesting.max_depth && depth > nesting.max_depth) {
+            std::string error = parseError(PRELUDE + nesting.make(depth));
+            if (error.find(NESTED_TOO_DEEP) == std::string::npos) {
+                std::cerr << nesting.name << ": expected " << NESTED_TOO_DEEP << " from the parser at depth " << depth
+                    << ", got " << (error.empty() ? "none" : error) << std::endl;
+                return EXIT_FAILURE;
+            }
+            case_depth = nesting.max_depth;
+        }
+
+        std::size_t half_tokens = 0, full_tokens = 0;
+        double half = parseSeconds(PRELUDE + nesting.make(case_depth / 2), iterations, half_tokens);
+        double full = parseSeconds(PRELUDE + nesting.make(case_depth), iterations, full_tokens);
+
+        std::cout << nesting.name << ": " << full * 1e3 << " ms, "
+            << full * 1e9 / full_tokens << " ns/token (" << half * 1e9 / half_tokens << " at half depth)";
+        if (case_depth != depth) std::cout << " at depth " << case_depth << ", deeper is rejected";
+        std::cout << std::endl;
+
+        Generated generated = generate(PRELUDE + nesting.make(case_depth));
+        bool expected = nesting.generate_error ? generated.error.find(nesting.generate_error) != std::string::npos : generated.error.empty();
+        if (!expected) {
+            std::cerr << nesting.name << ": expected " << (nesting.generate_error ? nesting.generate_error : "no error")
+                << " from the generator, got " << (generated.error.empty() ? "none" : generated.error) << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "    flatten " << generated.flatten_seconds * 1e3 << " ms, generate " << generated.generate_seconds * 1e3 << " ms";
+        if (nesting.generate_error) std::cout << " (" << nesting.generate_error << ")";
+        std::cout << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
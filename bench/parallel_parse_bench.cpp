@@ -0,0 +1,148 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/flat_ast.hpp"
+#include "corpus.hpp"
+
+/*
+    Parallel parsing benchmark.
+
+    Parses a program from CorpusGenerator, thousands of top-level functions
+    and procedures, with parse() and with parseParallel() on 1, 2, 4, ... up
+    to the machine's thread count, at least 2. Tokens are lexed once, only
+    parsing is timed. Every parallel AST is flattened and compared node by
+    node with the serial one, they must be identical except for which
+    occurrence of a type name a type node points at: whichever chunk interns
+    a type first decides that.
+
+    Before measuring, a program whose functions all take the same array,
+    vector and tuple types is parsed in parallel, every function must get
+    the same NodeType for each, as type equality is a pointer compare. A
+    program that declares a struct ahead of the functions using it must
+    still be split into chunks, and parse to the same AST as serially.
+
+    usage: parallel_parse_bench.o [size in MB] [iterations]
+*/
+
+bool sameAst(const FlatAst& expected, const FlatAst& actual) {
+    if (expected.size() != actual.size()) return false;
+
+    for (FlatIndex i = 0; i < expected.size(); i++) {
+        const FlatNode& a = expected.node(i);
+        const FlatNode& b = actual.node(i);
+        if (expected.kind(i) != actual.kind(i) || a.a != b.a || a.b != b.b || a.c != b.c) return false;
+
+        const Token* token_a = expected.token(i);
+        const Token* token_b = actual.token(i);
+        if (!token_a != !token_b) return false;
+        if (!token_a) continue;
+
+        if (expected.kind(i) == FlatKind::_type ? token_a->getStrValue() != token_b->getStrValue() : token_a->getOffset() != token_b->getOffset()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkSharedTypes() {
+    std::string source;
+    for (int i = 0; i < 4000; i++) {
+        source += "function f_" + std::to_string(i) + "(integer[3] a, vector<integer> b, tuple(integer, integer) c) returns integer[3] = a;\n";
+    }
+
+    Tokenizer tokenizer(source);
+    Parser parser(tokenizer.tokenize());
+    NodeProgram* program = parser.parseParallel(std::max(ThreadPool::defaultThreadCount(), 4u));
+
+    // the argument and return types of the first function
+    std::vector<NodeType*> expected;
+    for (NodeProgramElement* element : program->_elements) {
+        NodeFunctionDecleration* function = std::get<NodeFunctionDecleration*>(element->_element);
+        std::vector<NodeType*> types;
+        for (NodeFunctionDeclerationArgument* argument : function->_arguments) types.push_back(argument->_type);
+        types.push_back(function->_return_type);
+
+        if (expected.empty()) expected = types;
+        if (types != expected) return false;
+    }
+    return expected.size() == 4 && expected[0] == expected[3];
+}
+
+bool checkStructPrefix() {
+    std::string source = "struct Point(integer x, integer y);\n";
+    for (int i = 0; i < 4000; i++) {
+        source += "function f_" + std::to_string(i) + "(integer a) returns integer { Point p = (a, " + std::to_string(i) + "); return a; }\n";
+    }
+
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+    Parser serial{std::vector<Token>(tokens)};
+    Parser parser(std::move(tokens));
+    NodeProgram* program = parser.parseParallel(std::max(ThreadPool::defaultThreadCount(), 4u));
+    return parser.parallelChunks() > 1 && sameAst(FlatAst(serial.parse()), FlatAst(program));
+}
+
+int main(int argc, char* argv[]) {
+    if (!checkSharedTypes()) {
+        std::cerr << "parseParallel() built more than one NodeType for the same type" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!checkStructPrefix()) {
+        std::cerr << "parseParallel() did not split a program that declares a struct before its functions" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CorpusOptions options;
+    options.size = (argc > 1 ? std::stoul(argv[1]) : 8) * 1024 * 1024;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    std::string source = CorpusGenerator(options).generate();
+    Tokenizer tokenizer(source);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    // at least two threads, so a single core machine still checks the parallel path
+    unsigned int max_threads = std::max(ThreadPool::defaultThreadCount(), 2u);
+    std::vector<unsigned int> thread_counts{0};
+    for (unsigned int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::cout << "input: " << source.size() / (1024 * 1024) << " MB, " << tokens.size() << " tokens" << std::endl;
+
+    // thread count 0 is the serial parse() every other run is compared with
+    FlatAst serial;
+    double serial_seconds = 0;
+    for (unsigned int threads : thread_counts) {
+        double best_seconds = 0;
+        for (int i = 0; i < iterations; i++) {
+            // the parser takes its tokens over, the copy is not timed
+            std::vector<Token> input = tokens;
+
+            auto start = std::chrono::steady_clock::now();
+            Parser parser(std::move(input));
+            NodeProgram* program = threads ? parser.parseParallel(threads) : parser.parse();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+
+            if (i == 0 && !threads) {
+                serial = FlatAst(program);
+            } else if (i == 0 && !sameAst(serial, FlatAst(program))) {
+                std::cerr << "parseParallel(" << threads << ") built a different AST" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (!threads) {
+            serial_seconds = best_seconds;
+            std::cout << "parse():           " << best_seconds * 1e3 << " ms" << std::endl;
+        } else {
+            std::cout << "parseParallel(" << threads << "): " << best_seconds * 1e3 << " ms, "
+                << serial_seconds / best_seconds << "x" << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
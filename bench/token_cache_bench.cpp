@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/token_cache.hpp"
+
+/*
+    Token cache benchmark.
+
+    Writes a generated program to a temporary file and compares getting its
+    tokens the cold way, running `Tokenizer::tokenize()` over it, against the
+    warm way, loading a `.gaztok` cache written for it with TokenCache. Both
+    read the source through SourceFile like the compiler does, and the warm
+    load includes hashing the source to validate the cache.
+
+    usage: token_cache_bench.o [size in MB] [iterations]
+*/
+
+std::string makeSource(std::size_t target_size) {
+    static const char* lines[] = {
+        "var integer total = (alpha + beta) * gamma - 12;\n",
+        "if (index <= length_of) { result = result ** 2; } else { result = -result; }\n",
+        "loop while (count < 100) { count = count + 1; } // bump the counter\n",
+        "procedure step(var integer x, integer y) returns integer { return x .. y; }\n",
+        "\"total so far\" -> std_output; value <- std_input; 'c' -> std_output;\n",
+        "/* scale the result */ var real ratio = 3.25 * offset_of;\n",
+    };
+    const std::size_t line_count = sizeof(lines) / sizeof(lines[0]);
+
+    std::string source;
+    source.reserve(target_size + 128);
+    for (std::size_t i = 0; source.size() < target_size; i++) {
+        source += lines[(i * 7) % line_count];
+    }
+    return source;
+}
+
+bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        bool literal = a[i].getTokenType() == TokenType::_text || a[i].getTokenType() == TokenType::_char_lit;
+        if (a[i].getTokenType() != b[i].getTokenType() || a[i].getOffset() != b[i].getOffset() || a[i].getLength() != b[i].getLength() ||
+            a[i].getLine() != b[i].getLine() || a[i].getChar() != b[i].getChar() || a[i].getStrValue() != b[i].getStrValue() ||
+            a[i].getSymbol() != b[i].getSymbol() || (literal ? a[i].getLiteral() != b[i].getLiteral() : a[i].getIntValue() != b[i].getIntValue())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Run>
+double bestMillis(int iterations, Run run) {
+    double best_seconds = 0;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds * 1e3;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 16;
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::string path = "token_cache_bench.gaz";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        std::string source = makeSource(megabytes * 1024 * 1024);
+        file.write(source.data(), static_cast<std::streamsize>(source.size()));
+    }
+
+    SourceFile source;
+    if (!source.open(path)) {
+        std::cerr << "could not open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TokenCache cache(TokenCache::pathFor(path));
+    std::vector<Token> lexed;
+    std::optional<std::vector<Token>> loaded;
+
+    double cold = bestMillis(iterations, [&] {
+        Tokenizer tokenizer(source.content());
+        lexed = tokenizer.tokenize();
+    });
+
+    if (!cache.save(source.content(), lexed)) {
+        std::cerr << "could not write " << TokenCache::pathFor(path) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double warm = bestMillis(iterations, [&] {
+        loaded = cache.load(source.content());
+    });
+
+    bool same = loaded && sameTokens(lexed, *loaded);
+    std::remove(TokenCache::pathFor(path).c_str());
+    std::remove(path.c_str());
+
+    if (!same) {
+        std::cerr << "cached tokens differ from lexed tokens" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "input:      " << megabytes << " MB, " << lexed.size() << " tokens" << std::endl;
+    std::cout << "cold lex:   " << cold << " ms" << std::endl;
+    std::cout << "warm cache: " << warm << " ms" << std::endl;
+    std::cout << "speedup:    " << cold / warm << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
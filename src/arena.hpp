@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+    Bump-pointer arena for the AST.
+
+    make<T>() carves the object out of the current block by moving a
+    pointer, so nodes allocated one after another sit next to each other
+    in memory. Blocks are never freed one by one, the whole arena goes at
+    once when it is destroyed.
+
+    Objects that need a destructor (nodes holding a std::vector or a
+    std::variant of them) are recorded in a list kept in the arena itself
+    and destroyed in reverse order before the blocks are released, so
+    their heap storage does not leak either. Trivially destructible
+    objects cost nothing beyond their bytes.
+*/
+class Arena {
+private:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Cleanup {
+        void (*destroy)(void*);
+        void* object;
+        Cleanup* previous;
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::byte* m_next = nullptr;
+    std::byte* m_end = nullptr;
+    Cleanup* m_cleanups = nullptr;
+    std::size_t m_used = 0;
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+        std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(m_next) % alignment) % alignment;
+        if (!m_next || padding + size > static_cast<std::size_t>(m_end - m_next)) {
+            std::size_t block_size = std::max(BLOCK_SIZE, size + alignment);
+            m_blocks.push_back(std::unique_ptr<std::byte[]>(new std::byte[block_size]));
+            m_next = m_blocks.back().get();
+            m_end = m_next + block_size;
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(m_next) % alignment) % alignment;
+        }
+
+        void* memory = m_next + padding;
+        m_next += padding + size;
+        m_used += size;
+        return memory;
+    }
+
+    void release() {
+        for (Cleanup* cleanup = m_cleanups; cleanup; cleanup = cleanup->previous) {
+            cleanup->destroy(cleanup->object);
+        }
+        m_cleanups = nullptr;
+        m_blocks.clear();
+        m_next = m_end = nullptr;
+        m_used = 0;
+    }
+
+public:
+    Arena() {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            release();
+            m_blocks = std::move(other.m_blocks);
+            m_next = std::exchange(other.m_next, nullptr);
+            m_end = std::exchange(other.m_end, nullptr);
+            m_cleanups = std::exchange(other.m_cleanups, nullptr);
+            m_used = std::exchange(other.m_used, 0);
+        }
+        return *this;
+    }
+
+    ~Arena() {
+        release();
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            Cleanup* cleanup = new (allocate(sizeof(Cleanup), alignof(Cleanup))) Cleanup{
+                [](void* p) { static_cast<T*>(p)->~T(); }, object, m_cleanups
+            };
+            m_cleanups = cleanup;
+        }
+        return object;
+    }
+
+    // bytes handed out so far, not counting alignment padding and unused block tails
+    std::size_t used() const {
+        return m_used;
+    }
+
+    std::size_t blocks() const {
+        return m_blocks.size();
+    }
+};
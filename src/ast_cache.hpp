@@ -0,0 +1,389 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "flat_ast.hpp"
+#include "literal.hpp"
+#include "log.hpp"
+#include "source.hpp"
+#include "source_map.hpp"
+#include "symbol.hpp"
+#include "token_cache.hpp"
+
+/*
+    On-disk precompiled AST, the `.gazast` file next to a source file.
+
+    A cache file holds the FlatAst of one source file so an unchanged file
+    can be compiled without running the Tokenizer or the Parser. Like the
+    `.gaztok` token cache it is only valid for the exact source content,
+    compiler and parser mode it was written by, the header carries a hash
+    of each and anything that does not match is a miss.
+
+    Layout, native byte order:
+
+        Header
+        FlatNode[node_count]
+        Record[token_count]
+        FlatIndex extra[extra_count]
+        uint32_t symbol lengths[symbol_count]
+        uint32_t literal lengths[literal_count]
+        FlatKind kinds[node_count]
+        symbol names, then decoded literals, back to back
+
+    The node, extra and kind arrays are the FlatAst's own, copied in and
+    out with one memcpy each. Records are tokens as in the token cache:
+    symbols and literals are indices into the file, and so is the LiteralId
+    operand of a _character or _string node. On load the names and literals
+    are interned once and the indices mapped back to global ids.
+*/
+class AstCache {
+private:
+    static constexpr char MAGIC[8] = {'G', 'A', 'Z', 'A', 'S', 'T', '\0', '\0'};
+    static constexpr uint32_t FORMAT = 1;
+
+    struct Header {
+        char magic[8];
+        uint64_t version;
+        uint64_t source_hash;
+        uint64_t source_size;
+        uint32_t node_count;
+        uint32_t extra_count;
+        uint32_t token_count;
+        uint32_t symbol_count;
+        uint32_t literal_count;
+        uint32_t root_first;
+        uint32_t root_count;
+        // 1 when written from a parse with lazy bodies, whose AST leaves functions out
+        uint32_t lazy_bodies;
+    };
+
+    struct Record {
+        uint32_t offset;
+        uint32_t length;
+        // Token::getValue(), with symbols and literals as indices into the file's
+        uint32_t value;
+        uint8_t type;
+        uint8_t unused[3];
+    };
+
+    static_assert(sizeof(Header) % alignof(FlatNode) == 0 && sizeof(Record) == 16);
+
+    std::string m_path;
+    bool m_lazy_bodies;
+
+    static uint64_t version() {
+        std::string key = std::string(COMPILER_VERSION) + "/ast" + std::to_string(FORMAT) + "/" +
+            std::to_string(static_cast<int>(TokenType::_eof)) + "/" + std::to_string(static_cast<int>(FlatKind::_argument));
+        return TokenCache::hash(key);
+    }
+
+    static bool hasLiteral(FlatKind kind) {
+        return kind == FlatKind::_character || kind == FlatKind::_string;
+    }
+
+    /*
+        Whether the operands of node `index` are what its kind says they
+        are (see FlatKind): child nodes before `index`, since children are
+        flattened first, and m_extra ranges inside m_extra holding such
+        nodes. Anything else in a cache file would have the generator read
+        out of bounds or loop.
+    */
+    static bool validOperands(const FlatAst& ast, FlatIndex index, std::size_t token_count) {
+        const FlatNode& node = ast.m_nodes[index];
+        auto child = [&](FlatIndex child) {
+            return child == NO_NODE || child < index;
+        };
+        auto range = [&](FlatIndex first, uint64_t count) {
+            if (first + count > ast.m_extra.size()) return false;
+            for (uint64_t i = 0; i < count; i++) {
+                if (!child(ast.m_extra[first + i])) return false;
+            }
+            return true;
+        };
+
+        switch (ast.m_kinds[index]) {
+        case FlatKind::_integer:
+        case FlatKind::_boolean:
+        case FlatKind::_character:
+        case FlatKind::_string:
+        case FlatKind::_generator:
+        case FlatKind::_type:
+        case FlatKind::_statement_token:
+            return true;
+
+        case FlatKind::_unary:
+        case FlatKind::_call:
+        case FlatKind::_statement_expression:
+        case FlatKind::_identifier:
+        case FlatKind::_type_vector:
+        case FlatKind::_return:
+        case FlatKind::_typealias:
+            return child(node.a);
+
+        case FlatKind::_binary:
+        case FlatKind::_range:
+        case FlatKind::_assign:
+        case FlatKind::_identifier_call:
+        case FlatKind::_type_array:
+        case FlatKind::_loop:
+        case FlatKind::_argument:
+            return child(node.a) && child(node.b);
+
+        case FlatKind::_identifier_index:
+        case FlatKind::_decleration:
+            return child(node.a) && child(node.b) && child(node.c);
+
+        case FlatKind::_tuple:
+        case FlatKind::_list:
+        case FlatKind::_type_tuple:
+        case FlatKind::_block:
+            return range(node.b, node.c);
+
+        case FlatKind::_function_call:
+        case FlatKind::_identifier_tuple:
+        case FlatKind::_struct:
+            return child(node.a) && range(node.b, node.c);
+
+        case FlatKind::_control:
+            return child(node.a) && range(node.b, 2 * static_cast<uint64_t>(node.c));
+
+        case FlatKind::_stream:
+            // a is the operator token
+            return (node.a == NO_TOKEN || node.a < token_count) && child(node.b);
+
+        case FlatKind::_function:
+        case FlatKind::_procedure:
+            // the arguments, then the return type and the two bodies
+            return child(node.a) && range(node.b, node.c + static_cast<uint64_t>(3));
+        }
+        return false;
+    }
+
+    template <typename T>
+    static void append(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static void appendArray(std::string& out, const std::vector<T>& values) {
+        out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    static void readArray(std::vector<T>& values, const char* data, std::size_t count) {
+        values.resize(count);
+        std::memcpy(values.data(), data, count * sizeof(T));
+    }
+
+public:
+    // `lazy_bodies` is the parser mode a cached AST must have been built in
+    AstCache(std::string path, bool lazy_bodies = false) : m_path(std::move(path)), m_lazy_bodies(lazy_bodies) {}
+
+    // the cache file used for the source file at `source_path`
+    static std::string pathFor(const std::string& source_path) {
+        return source_path + ".gazast";
+    }
+
+    /*
+        Returns the AST of `content` if the cache file exists and was written
+        for exactly this content, compiler and parser mode, nothing
+        otherwise. Identifiers and literals are interned into the global
+        tables and `content` is registered as the source of every token.
+    */
+    std::optional<FlatAst> load(std::string_view content) const {
+        SourceFile file;
+        if (!file.open(m_path)) return std::nullopt;
+
+        std::string_view data = file.content();
+        if (data.size() < sizeof(Header)) return std::nullopt;
+
+        Header header;
+        std::memcpy(&header, data.data(), sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != version() ||
+            header.source_size != content.size() || header.lazy_bodies != m_lazy_bodies) {
+            return std::nullopt;
+        }
+
+        std::size_t strings = header.symbol_count + static_cast<std::size_t>(header.literal_count);
+        std::size_t nodes_at = sizeof(Header);
+        std::size_t records_at = nodes_at + header.node_count * sizeof(FlatNode);
+        std::size_t extra_at = records_at + header.token_count * sizeof(Record);
+        std::size_t lengths_at = extra_at + header.extra_count * sizeof(FlatIndex);
+        std::size_t kinds_at = lengths_at + strings * sizeof(uint32_t);
+        std::size_t body = kinds_at + header.node_count * sizeof(FlatKind);
+        if (body > data.size()) return std::nullopt;
+
+        if (static_cast<std::size_t>(header.root_first) + header.root_count > header.extra_count) return std::nullopt;
+
+        if (header.source_hash != TokenCache::hash(content)) return std::nullopt;
+
+        // names and literals back to back after the kinds
+        const uint32_t* lengths = reinterpret_cast<const uint32_t*>(data.data() + lengths_at);
+        std::vector<SymbolId> symbols(header.symbol_count);
+        std::vector<LiteralId> literals(header.literal_count);
+
+        std::size_t text = body;
+        for (std::size_t i = 0; i < strings; i++) {
+            if (lengths[i] > data.size() - text) return std::nullopt;
+            std::string_view value = data.substr(text, lengths[i]);
+            if (i < header.symbol_count) {
+                symbols[i] = SymbolTable::global().intern(value);
+            } else {
+                literals[i - header.symbol_count] = LiteralTable::global().intern(value);
+            }
+            text += lengths[i];
+        }
+
+        FlatAst ast;
+        readArray(ast.m_nodes, data.data() + nodes_at, header.node_count);
+        readArray(ast.m_extra, data.data() + extra_at, header.extra_count);
+        readArray(ast.m_kinds, data.data() + kinds_at, header.node_count);
+        ast.m_root_first = header.root_first;
+        ast.m_root_count = header.root_count;
+
+        for (std::size_t i = 0; i < header.node_count; i++) {
+            FlatNode& node = ast.m_nodes[i];
+            if (ast.m_kinds[i] > FlatKind::_argument || (node.token != NO_TOKEN && node.token >= header.token_count)) {
+                return std::nullopt;
+            }
+
+            if (!validOperands(ast, static_cast<FlatIndex>(i), header.token_count)) return std::nullopt;
+
+            if (hasLiteral(ast.m_kinds[i]) && node.a != NO_LITERAL) {
+                if (node.a >= literals.size()) return std::nullopt;
+                node.a = literals[node.a];
+            }
+        }
+
+        for (FlatIndex element : ast.elements()) {
+            if (element != NO_NODE && element >= header.node_count) return std::nullopt;
+        }
+
+        const Record* records = reinterpret_cast<const Record*>(data.data() + records_at);
+        SourceId source = SourceMap::global().add(content);
+        ast.m_tokens.resize(header.token_count);
+
+        for (std::size_t i = 0; i < header.token_count; i++) {
+            const Record& record = records[i];
+            if (record.type > static_cast<uint8_t>(TokenType::_eof) || record.offset > content.size() || record.length > content.size() - record.offset) {
+                return std::nullopt;
+            }
+
+            Token& token = ast.m_tokens[i];
+            token = Token(static_cast<TokenType>(record.type), source, record.offset, record.length);
+            token.setValue(record.value);
+
+            if (token.getTokenType() == TokenType::_identifier) {
+                if (record.value >= symbols.size()) return std::nullopt;
+                token.setSymbol(symbols[record.value]);
+            } else if (token.isLiteral()) {
+                if (record.value >= literals.size()) return std::nullopt;
+                token.setLiteral(literals[record.value]);
+            }
+        }
+
+        LOG_INFO("Loaded " + std::to_string(ast.size()) + " AST nodes from " + m_path);
+        return ast;
+    }
+
+    /*
+        Writes the AST of `content` to the cache file, under a temporary name
+        renamed into place like the token cache.
+    */
+    bool save(std::string_view content, const FlatAst& ast) const {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = version();
+        header.source_hash = TokenCache::hash(content);
+        header.source_size = content.size();
+        header.node_count = static_cast<uint32_t>(ast.m_nodes.size());
+        header.extra_count = static_cast<uint32_t>(ast.m_extra.size());
+        header.token_count = static_cast<uint32_t>(ast.m_tokens.size());
+        header.root_first = ast.m_root_first;
+        header.root_count = ast.m_root_count;
+        header.lazy_bodies = m_lazy_bodies;
+
+        // global ids to indices in the file, in order of first use
+        std::vector<uint32_t> symbol_index(SymbolTable::global().size(), NO_SYMBOL);
+        std::vector<uint32_t> literal_index(LiteralTable::global().size(), NO_LITERAL);
+        std::vector<SymbolId> symbols;
+        std::vector<LiteralId> literals;
+
+        auto literalIndex = [&](LiteralId literal) {
+            uint32_t& index = literal_index[literal];
+            if (index == NO_LITERAL) {
+                index = static_cast<uint32_t>(literals.size());
+                literals.push_back(literal);
+            }
+            return index;
+        };
+
+        std::vector<FlatNode> nodes = ast.m_nodes;
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            if (hasLiteral(ast.m_kinds[i]) && nodes[i].a != NO_LITERAL) nodes[i].a = literalIndex(nodes[i].a);
+        }
+
+        std::string out;
+        out.reserve(sizeof(Header) + nodes.size() * (sizeof(FlatNode) + sizeof(FlatKind)) +
+            ast.m_tokens.size() * sizeof(Record) + ast.m_extra.size() * sizeof(FlatIndex));
+        append(out, header);
+        appendArray(out, nodes);
+
+        for (const Token& token : ast.m_tokens) {
+            Record record{};
+            record.offset = static_cast<uint32_t>(token.getOffset());
+            record.length = static_cast<uint32_t>(token.getLength());
+            record.type = static_cast<uint8_t>(token.getTokenType());
+            record.value = token.getValue();
+
+            if (token.getSymbol() != NO_SYMBOL) {
+                uint32_t& index = symbol_index[token.getSymbol()];
+                if (index == NO_SYMBOL) {
+                    index = static_cast<uint32_t>(symbols.size());
+                    symbols.push_back(token.getSymbol());
+                }
+                record.value = index;
+            } else if (token.isLiteral()) {
+                record.value = literalIndex(token.getLiteral());
+            }
+            append(out, record);
+        }
+
+        appendArray(out, ast.m_extra);
+        for (SymbolId id : symbols) append(out, static_cast<uint32_t>(SymbolTable::global().name(id).size()));
+        for (LiteralId id : literals) append(out, static_cast<uint32_t>(LiteralTable::global().text(id).size()));
+        appendArray(out, ast.m_kinds);
+        for (SymbolId id : symbols) out.append(SymbolTable::global().name(id));
+        for (LiteralId id : literals) out.append(LiteralTable::global().text(id));
+
+        // patch the counts into the header written above
+        header.symbol_count = static_cast<uint32_t>(symbols.size());
+        header.literal_count = static_cast<uint32_t>(literals.size());
+        std::memcpy(out.data(), &header, sizeof(Header));
+
+        std::string temp_path = m_path + "." + std::to_string(getpid()) + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(temp_path.c_str(), m_path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+
+        LOG_INFO("Wrote " + std::to_string(ast.size()) + " AST nodes to " + m_path);
+        return true;
+    }
+};
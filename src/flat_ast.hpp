@@ -0,0 +1,663 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "./parser.hpp"
+
+/*
+    Flat, index-based copy of the AST.
+
+    The tree built by the Parser is a graph of pointers into the arena,
+    every step of a traversal follows one of them to wherever the node was
+    allocated. FlatAst keeps the same tree in a few contiguous arrays
+    instead:
+
+    * m_kinds[i] is the tag of node i, kept apart from the node data like
+      TokenStream keeps token kinds
+    * m_nodes[i] holds a token index and up to three 32-bit operands, whose
+      meaning depends on the kind (see FlatKind)
+    * m_extra holds the variable length child lists, a node refers to them
+      by first index and count
+    * m_tokens holds a copy of every token a node refers to
+
+    Children are always flattened before their parent, so the root list of
+    the program comes last and a node never refers to a higher index than
+    its own. Every array holds trivially copyable values, so the whole AST
+    can be copied, hashed or written out with memcpy.
+*/
+using FlatIndex = uint32_t;
+constexpr FlatIndex NO_NODE = UINT32_MAX;
+constexpr FlatIndex NO_TOKEN = UINT32_MAX;
+
+/*
+    Node kinds. Operands are named a, b and c in FlatNode, [b, b + c) is a
+    range of m_extra unless noted otherwise.
+*/
+enum class FlatKind : uint8_t {
+    // expressions
+    _integer,           // token, a/b: low and high 32 bits of the value
+    _boolean,           // token, a: value
+    _character,         // token, a: LiteralId
+    _string,            // token, a: LiteralId
+    _binary,            // token: operator, a: lhs, b: rhs
+    _unary,             // token: operator, a: operand
+    _generator,         // token
+    _function_call,     // a: identifier, [b, b + c): argument expressions
+    _tuple,             // [b, b + c): expressions
+    _list,              // [b, b + c): items
+    _range,             // a: start, b: end
+    _assign,            // token: operator, a: lhs, b: rhs
+    _call,              // a: function call, also used as a statement
+    _statement_expression, // a: statement
+
+    // identifiers, a is the member access identifier or NO_NODE
+    _identifier,        // token: name
+    _identifier_tuple,  // [b, b + c): identifiers
+    _identifier_index,  // b: identifier, c: index expression
+    _identifier_call,   // b: function call
+
+    // types
+    _type,              // token: type name
+    _type_tuple,        // [b, b + c): types
+    _type_vector,       // a: element type
+    _type_array,        // a: element type, b: size (an _integer node)
+    _struct,            // a: type identifier, [b, b + c): arguments
+
+    // statements
+    _decleration,       // token: qualifier, a: type, b: identifier, c: expression
+    _block,             // [b, b + c): elements
+    _control,           // [b, b + 2c): condition and statement pairs, if first, a: else statement
+    _statement_token,   // token: break or continue
+    _return,            // token, a: expression
+    _stream,            // token: destination, a: operator token, b: expression
+    _loop,              // a: condition, b: body, c: 1 when the condition comes first
+    _typealias,         // token: new name, a: original type
+
+    // functions, a: identifier, [b, b + c): arguments
+    // m_extra[b + c .. b + c + 2]: return type, body statement, body expression
+    _function,
+    _procedure,
+    _argument,          // token: qualifier, a: type, b: identifier
+};
+
+struct FlatNode {
+    FlatIndex token = NO_TOKEN;
+    FlatIndex a = NO_NODE;
+    FlatIndex b = NO_NODE;
+    FlatIndex c = NO_NODE;
+};
+
+/*
+    What a FlattenTask does with its node, which is one of these parser
+    types. The tree is flattened with an explicit task stack instead of
+    recursion, so deeply nested expressions or blocks can not overflow the
+    call stack.
+*/
+enum class FlattenStep : uint8_t {
+    _element,           // NodeProgramElement
+    _statement,         // NodeStatement
+    _expression,        // NodeExpression
+    _identifier,        // NodeIdentifier
+    _function_call,     // NodeFunctionCall
+    _call,              // NodeCall
+    _assign,            // NodeAssign
+    _argument,          // NodeFunctionDeclerationArgument
+    _type,              // NodeType
+};
+
+struct FlattenTask {
+    FlattenStep step;
+    // false: push the children of node, true: add node, its children are flattened
+    bool build;
+    void* node;
+};
+
+static_assert(sizeof(FlatNode) == 16);
+static_assert(std::is_trivially_copyable_v<FlatNode>);
+static_assert(std::is_trivially_copyable_v<Token>);
+
+class FlatAst {
+private:
+    // writes and reads these arrays as they are
+    friend class AstCache;
+
+    std::vector<FlatKind> m_kinds;
+    std::vector<FlatNode> m_nodes;
+    std::vector<FlatIndex> m_extra;
+    std::vector<Token> m_tokens;
+    // [m_root_first, m_root_first + m_root_count) of m_extra are the program elements
+    FlatIndex m_root_first = 0;
+    FlatIndex m_root_count = 0;
+
+    // only used while flattening, m_results holds the indices of flattened children
+    std::vector<FlattenTask> m_tasks;
+    std::vector<FlatIndex> m_results;
+
+    FlatIndex add(FlatKind kind, FlatNode node) {
+        m_kinds.push_back(kind);
+        m_nodes.push_back(node);
+        return static_cast<FlatIndex>(m_nodes.size() - 1);
+    }
+
+    FlatIndex copyToken(const Token* token) {
+        if (!token) return NO_TOKEN;
+        m_tokens.push_back(*token);
+        return static_cast<FlatIndex>(m_tokens.size() - 1);
+    }
+
+    // children are flattened first, then copied into m_extra in one piece
+    FlatIndex list(const std::vector<FlatIndex>& children) {
+        FlatIndex first = static_cast<FlatIndex>(m_extra.size());
+        m_extra.insert(m_extra.end(), children.begin(), children.end());
+        return first;
+    }
+
+    template <typename T, typename Flatten>
+    FlatNode listNode(const std::vector<T*>& items, Flatten flatten, FlatIndex a = NO_NODE) {
+        std::vector<FlatIndex> children;
+        children.reserve(items.size());
+        for (T* item : items) children.push_back(flatten(item));
+        return FlatNode{.a = a, .b = list(children), .c = static_cast<FlatIndex>(children.size())};
+    }
+
+    // the last `count` results, in the order they were produced, moved into m_extra in one piece
+    FlatIndex popList(std::size_t count) {
+        FlatIndex first = static_cast<FlatIndex>(m_extra.size());
+        m_extra.insert(m_extra.end(), m_results.end() - count, m_results.end());
+        m_results.resize(m_results.size() - count);
+        return first;
+    }
+
+    FlatIndex pop() {
+        FlatIndex result = m_results.back();
+        m_results.pop_back();
+        return result;
+    }
+
+    // pushes the task that builds `node` once the children pushed after it are flattened
+    void deferBuild(FlattenStep step, void* node) {
+        m_tasks.push_back({step, true, node});
+    }
+
+    void deferChild(FlattenStep step, void* node) {
+        m_tasks.push_back({step, false, node});
+    }
+
+    // children go on the task stack last first, so they are flattened in order
+    template <typename T>
+    void deferChildren(FlattenStep step, const std::vector<T*>& children) {
+        for (std::size_t i = children.size(); i-- > 0;) deferChild(step, children[i]);
+    }
+
+    /*
+        Flattens `node` and everything below it and returns its index. Tasks
+        run off m_tasks until the ones this call pushed are done, so a task
+        may call flatten() again for a small subtree.
+    */
+    FlatIndex flatten(FlattenStep step, void* node) {
+        std::size_t base = m_tasks.size();
+        deferChild(step, node);
+
+        while (m_tasks.size() > base) {
+            FlattenTask task = m_tasks.back();
+            m_tasks.pop_back();
+
+            if (!task.node) {
+                m_results.push_back(NO_NODE);
+            } else if (task.build) {
+                m_results.push_back(build(task));
+            } else {
+                expand(task);
+            }
+        }
+        return pop();
+    }
+
+    FlatIndex flattenInteger(NodeInteger* integer) {
+        if (!integer) return NO_NODE;
+        uint64_t bits = static_cast<uint64_t>(integer->_value);
+        return add(FlatKind::_integer, {
+            .token = copyToken(integer->_token),
+            .a = static_cast<FlatIndex>(bits),
+            .b = static_cast<FlatIndex>(bits >> 32)
+        });
+    }
+
+    FlatIndex flattenType(NodeType* type) {
+        if (!type) return NO_NODE;
+
+        return std::visit([&](auto* node) -> FlatIndex {
+            using T = std::remove_pointer_t<decltype(node)>;
+            if (!node) return NO_NODE;
+
+            if constexpr (std::is_same_v<T, Token>) {
+                return add(FlatKind::_type, {.token = copyToken(node)});
+            } else if constexpr (std::is_same_v<T, NodeTypeTuple>) {
+                return flattenTypeTuple(node);
+            } else if constexpr (std::is_same_v<T, NodeTypeVector>) {
+                return add(FlatKind::_type_vector, {.a = flattenType(node->_type)});
+            } else {
+                FlatIndex element = flattenType(node->_type);
+                FlatIndex size = flattenInteger(node->_index);
+                return add(FlatKind::_type_array, {.a = element, .b = size});
+            }
+        }, type->_type);
+    }
+
+    FlatIndex flattenTypeTuple(NodeTypeTuple* tuple) {
+        return add(FlatKind::_type_tuple, listNode(tuple->_types, [&](NodeType* t) { return flattenType(t); }));
+    }
+
+    // a struct, type name, type tuple or type, all before the declared identifier
+    FlatIndex flattenDeclerationType(NodeDecleration* decleration) {
+        return std::visit([&](auto* node) -> FlatIndex {
+            using T = std::remove_pointer_t<decltype(node)>;
+            if (!node) return NO_NODE;
+
+            if constexpr (std::is_same_v<T, NodeStruct>) {
+                FlatIndex identifier = flatten(FlattenStep::_identifier, node->_type);
+                for (NodeFunctionDeclerationArgument* argument : node->_arguments) {
+                    m_results.push_back(flatten(FlattenStep::_argument, argument));
+                }
+                FlatIndex count = static_cast<FlatIndex>(node->_arguments.size());
+                return add(FlatKind::_struct, {.a = identifier, .b = popList(count), .c = count});
+            } else if constexpr (std::is_same_v<T, Token>) {
+                return add(FlatKind::_type, {.token = copyToken(node)});
+            } else if constexpr (std::is_same_v<T, NodeTypeTuple>) {
+                return flattenTypeTuple(node);
+            } else {
+                return flattenType(node);
+            }
+        }, decleration->_type);
+    }
+
+    /*
+        Pushes the tasks for the children of `task.node` after the one that
+        builds it, or pushes its index right away when it has none to wait
+        for. A node that only wraps another, like an expression holding a
+        function call, hands over to the task for the inner node.
+    */
+    void expand(FlattenTask task) {
+        switch (task.step) {
+        case FlattenStep::_element: {
+            NodeProgramElement* element = static_cast<NodeProgramElement*>(task.node);
+            std::visit([&](auto* node) {
+                using T = std::remove_pointer_t<decltype(node)>;
+                if (!node) {
+                    m_results.push_back(NO_NODE);
+                } else if constexpr (std::is_same_v<T, NodeStatement>) {
+                    deferChild(FlattenStep::_statement, node);
+                } else if constexpr (std::is_same_v<T, NodeFunctionDecleration>) {
+                    deferBuild(FlattenStep::_element, element);
+                    deferChild(FlattenStep::_expression, node->_expression);
+                    deferChild(FlattenStep::_statement, node->_statement);
+                    deferChild(FlattenStep::_type, node->_return_type);
+                    deferChildren(FlattenStep::_argument, node->_arguments);
+                    deferChild(FlattenStep::_identifier, node->_identifier);
+                } else {
+                    FlatIndex original = flattenType(node->_original);
+                    m_results.push_back(add(FlatKind::_typealias, {.token = copyToken(node->_new), .a = original}));
+                }
+            }, element->_element);
+            return;
+        }
+
+        case FlattenStep::_statement: {
+            NodeStatement* statement = static_cast<NodeStatement*>(task.node);
+            std::visit([&](auto* node) {
+                using T = std::remove_pointer_t<decltype(node)>;
+                if (!node) {
+                    m_results.push_back(NO_NODE);
+                } else if constexpr (std::is_same_v<T, NodeDecleration>) {
+                    m_results.push_back(flattenDeclerationType(node));
+                    deferBuild(FlattenStep::_statement, statement);
+                    deferChild(FlattenStep::_expression, node->_expression);
+                    deferChild(FlattenStep::_identifier, node->_identifier);
+                } else if constexpr (std::is_same_v<T, NodeBlock>) {
+                    deferBuild(FlattenStep::_statement, statement);
+                    deferChildren(FlattenStep::_element, node->_elements);
+                } else if constexpr (std::is_same_v<T, NodeControl>) {
+                    deferBuild(FlattenStep::_statement, statement);
+                    deferChild(FlattenStep::_statement, node->_statement_else);
+                    for (std::size_t i = node->_else_if.size(); i-- > 0;) {
+                        deferChild(FlattenStep::_statement, node->_else_if[i].second);
+                        deferChild(FlattenStep::_expression, node->_else_if[i].first);
+                    }
+                    deferChild(FlattenStep::_statement, node->_if.second);
+                    deferChild(FlattenStep::_expression, node->_if.first);
+                } else if constexpr (std::is_same_v<T, NodeStatementToken>) {
+                    m_results.push_back(add(FlatKind::_statement_token, {.token = copyToken(node->_token)}));
+                } else if constexpr (std::is_same_v<T, NodeReturn> || std::is_same_v<T, NodeStream>) {
+                    deferBuild(FlattenStep::_statement, statement);
+                    deferChild(FlattenStep::_expression, node->_expression);
+                } else if constexpr (std::is_same_v<T, NodeLoop>) {
+                    deferBuild(FlattenStep::_statement, statement);
+                    deferChild(FlattenStep::_statement, node->_statement);
+                    deferChild(FlattenStep::_expression, node->_expression);
+                } else if constexpr (std::is_same_v<T, NodeCall>) {
+                    deferChild(FlattenStep::_call, node);
+                } else {
+                    deferChild(FlattenStep::_assign, node);
+                }
+            }, statement->_statement);
+            return;
+        }
+
+        case FlattenStep::_expression: {
+            NodeExpression* expression = static_cast<NodeExpression*>(task.node);
+            std::visit([&](auto* node) {
+                using T = std::remove_pointer_t<decltype(node)>;
+                if (!node) {
+                    m_results.push_back(NO_NODE);
+                } else if constexpr (std::is_same_v<T, NodeExpressionBinary>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChild(FlattenStep::_expression, node->_rhs);
+                    deferChild(FlattenStep::_expression, node->_lhs);
+                } else if constexpr (std::is_same_v<T, NodeExpressionUnary>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChild(FlattenStep::_expression, node->_expression);
+                } else if constexpr (std::is_same_v<T, NodeInteger>) {
+                    m_results.push_back(flattenInteger(node));
+                } else if constexpr (std::is_same_v<T, NodeBoolean>) {
+                    m_results.push_back(add(FlatKind::_boolean, {.token = copyToken(node->_token), .a = node->_value}));
+                } else if constexpr (std::is_same_v<T, NodeCharacter>) {
+                    m_results.push_back(add(FlatKind::_character, {.token = copyToken(node->_token), .a = node->_literal}));
+                } else if constexpr (std::is_same_v<T, NodeString>) {
+                    m_results.push_back(add(FlatKind::_string, {.token = copyToken(node->_token), .a = node->_literal}));
+                } else if constexpr (std::is_same_v<T, NodeGenerator>) {
+                    m_results.push_back(add(FlatKind::_generator, {.token = copyToken(node->_token)}));
+                } else if constexpr (std::is_same_v<T, NodeFunctionCall>) {
+                    deferChild(FlattenStep::_function_call, node);
+                } else if constexpr (std::is_same_v<T, NodeTuple>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChildren(FlattenStep::_expression, node->_expressions);
+                } else if constexpr (std::is_same_v<T, NodeIdentifier>) {
+                    deferChild(FlattenStep::_identifier, node);
+                } else if constexpr (std::is_same_v<T, NodeList>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChildren(FlattenStep::_expression, node->_items);
+                } else if constexpr (std::is_same_v<T, NodeStatement>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChild(FlattenStep::_statement, node);
+                } else if constexpr (std::is_same_v<T, NodeAssign>) {
+                    deferChild(FlattenStep::_assign, node);
+                } else if constexpr (std::is_same_v<T, NodeRange>) {
+                    deferBuild(FlattenStep::_expression, expression);
+                    deferChild(FlattenStep::_expression, node->_end);
+                    deferChild(FlattenStep::_expression, node->_start);
+                } else {
+                    deferChild(FlattenStep::_call, node);
+                }
+            }, expression->_expression);
+            return;
+        }
+
+        case FlattenStep::_identifier: {
+            // the member access is flattened before the identifier itself
+            NodeIdentifier* identifier = static_cast<NodeIdentifier*>(task.node);
+            deferBuild(FlattenStep::_identifier, identifier);
+
+            if (auto tuple = std::get_if<NodeTupleIdentifier*>(&identifier->_identifier); tuple && *tuple) {
+                deferChildren(FlattenStep::_identifier, (*tuple)->_identifiers);
+            } else if (auto index = std::get_if<NodeArrayIndex*>(&identifier->_identifier); index && *index) {
+                deferChild(FlattenStep::_expression, (*index)->_expression);
+                deferChild(FlattenStep::_identifier, (*index)->_identifier);
+            } else if (auto call = std::get_if<NodeFunctionCall*>(&identifier->_identifier)) {
+                deferChild(FlattenStep::_function_call, *call);
+            }
+            deferChild(FlattenStep::_identifier, identifier->_access_token);
+            return;
+        }
+
+        case FlattenStep::_function_call: {
+            NodeFunctionCall* call = static_cast<NodeFunctionCall*>(task.node);
+            deferBuild(FlattenStep::_function_call, call);
+            for (std::size_t i = call->_arguments.size(); i-- > 0;) {
+                NodeFunctionCallArgument* argument = call->_arguments[i];
+                deferChild(FlattenStep::_expression, argument ? argument->_expression : nullptr);
+            }
+            deferChild(FlattenStep::_identifier, call->_identifier);
+            return;
+        }
+
+        case FlattenStep::_call:
+            deferBuild(FlattenStep::_call, task.node);
+            deferChild(FlattenStep::_function_call, static_cast<NodeCall*>(task.node)->_function_call);
+            return;
+
+        case FlattenStep::_assign: {
+            NodeAssign* assign = static_cast<NodeAssign*>(task.node);
+            deferBuild(FlattenStep::_assign, assign);
+            deferChild(FlattenStep::_expression, assign->_rhs);
+            deferChild(FlattenStep::_expression, assign->_lhs);
+            return;
+        }
+
+        case FlattenStep::_argument: {
+            NodeFunctionDeclerationArgument* argument = static_cast<NodeFunctionDeclerationArgument*>(task.node);
+            deferBuild(FlattenStep::_argument, argument);
+            deferChild(FlattenStep::_identifier, argument->_identifier);
+            deferChild(FlattenStep::_type, argument->_type);
+            return;
+        }
+
+        case FlattenStep::_type:
+            m_results.push_back(flattenType(static_cast<NodeType*>(task.node)));
+            return;
+        }
+    }
+
+    // adds the node of `task`, whose children's indices are the last results
+    FlatIndex build(FlattenTask task) {
+        switch (task.step) {
+        case FlattenStep::_element: {
+            // only a function waits on its children
+            NodeFunctionDecleration* function = std::get<NodeFunctionDecleration*>(static_cast<NodeProgramElement*>(task.node)->_element);
+            FlatIndex count = static_cast<FlatIndex>(function->_arguments.size());
+            FlatIndex first = popList(count + 3);
+            FlatIndex identifier = pop();
+
+            FlatKind kind = function->is_procedure ? FlatKind::_procedure : FlatKind::_function;
+            return add(kind, {.a = identifier, .b = first, .c = count});
+        }
+
+        case FlattenStep::_statement:
+            return std::visit([&](auto* node) -> FlatIndex {
+                using T = std::remove_pointer_t<decltype(node)>;
+
+                if constexpr (std::is_same_v<T, NodeDecleration>) {
+                    FlatIndex expression = pop();
+                    FlatIndex identifier = pop();
+                    FlatIndex type = pop();
+                    FlatIndex qualifier = node->_qualifier ? copyToken(node->_qualifier->_token) : NO_TOKEN;
+                    return add(FlatKind::_decleration, {.token = qualifier, .a = type, .b = identifier, .c = expression});
+                } else if constexpr (std::is_same_v<T, NodeBlock>) {
+                    FlatIndex count = static_cast<FlatIndex>(node->_elements.size());
+                    return add(FlatKind::_block, {.b = popList(count), .c = count});
+                } else if constexpr (std::is_same_v<T, NodeControl>) {
+                    FlatIndex otherwise = pop();
+                    FlatIndex pairs = static_cast<FlatIndex>(node->_else_if.size() + 1);
+                    return add(FlatKind::_control, {.a = otherwise, .b = popList(2 * pairs), .c = pairs});
+                } else if constexpr (std::is_same_v<T, NodeReturn>) {
+                    FlatIndex expression = pop();
+                    return add(FlatKind::_return, {.token = copyToken(node->_token), .a = expression});
+                } else if constexpr (std::is_same_v<T, NodeStream>) {
+                    FlatIndex expression = pop();
+                    FlatIndex op = copyToken(node->_operator);
+                    return add(FlatKind::_stream, {.token = copyToken(node->_destination), .a = op, .b = expression});
+                } else if constexpr (std::is_same_v<T, NodeLoop>) {
+                    FlatIndex body = pop();
+                    FlatIndex condition = pop();
+                    return add(FlatKind::_loop, {.a = condition, .b = body, .c = node->_predicated});
+                } else {
+                    return NO_NODE;
+                }
+            }, static_cast<NodeStatement*>(task.node)->_statement);
+
+        case FlattenStep::_expression:
+            return std::visit([&](auto* node) -> FlatIndex {
+                using T = std::remove_pointer_t<decltype(node)>;
+
+                if constexpr (std::is_same_v<T, NodeExpressionBinary>) {
+                    FlatIndex rhs = pop();
+                    FlatIndex lhs = pop();
+                    FlatIndex op = node->_operator ? copyToken(node->_operator->_token) : NO_TOKEN;
+                    return add(FlatKind::_binary, {.token = op, .a = lhs, .b = rhs});
+                } else if constexpr (std::is_same_v<T, NodeExpressionUnary>) {
+                    FlatIndex operand = pop();
+                    FlatIndex op = node->_operator ? copyToken(node->_operator->_token) : NO_TOKEN;
+                    return add(FlatKind::_unary, {.token = op, .a = operand});
+                } else if constexpr (std::is_same_v<T, NodeTuple>) {
+                    FlatIndex count = static_cast<FlatIndex>(node->_expressions.size());
+                    return add(FlatKind::_tuple, {.b = popList(count), .c = count});
+                } else if constexpr (std::is_same_v<T, NodeList>) {
+                    FlatIndex count = static_cast<FlatIndex>(node->_items.size());
+                    return add(FlatKind::_list, {.b = popList(count), .c = count});
+                } else if constexpr (std::is_same_v<T, NodeStatement>) {
+                    return add(FlatKind::_statement_expression, {.a = pop()});
+                } else if constexpr (std::is_same_v<T, NodeRange>) {
+                    FlatIndex end = pop();
+                    FlatIndex start = pop();
+                    return add(FlatKind::_range, {.a = start, .b = end});
+                } else {
+                    return NO_NODE;
+                }
+            }, static_cast<NodeExpression*>(task.node)->_expression);
+
+        case FlattenStep::_identifier: {
+            NodeIdentifier* identifier = static_cast<NodeIdentifier*>(task.node);
+
+            if (auto name = std::get_if<NodeIdentifierToken*>(&identifier->_identifier)) {
+                FlatIndex access = pop();
+                return add(FlatKind::_identifier, {.token = *name ? copyToken((*name)->_token) : NO_TOKEN, .a = access});
+            }
+            if (auto tuple = std::get_if<NodeTupleIdentifier*>(&identifier->_identifier)) {
+                if (!*tuple) return add(FlatKind::_identifier_tuple, {.a = pop(), .b = 0, .c = 0});
+                FlatIndex count = static_cast<FlatIndex>((*tuple)->_identifiers.size());
+                FlatIndex first = popList(count);
+                FlatIndex access = pop();
+                return add(FlatKind::_identifier_tuple, {.a = access, .b = first, .c = count});
+            }
+            if (auto index = std::get_if<NodeArrayIndex*>(&identifier->_identifier)) {
+                FlatIndex at = *index ? pop() : NO_NODE;
+                FlatIndex array = *index ? pop() : NO_NODE;
+                FlatIndex access = pop();
+                return add(FlatKind::_identifier_index, {.a = access, .b = array, .c = at});
+            }
+            FlatIndex call = pop();
+            FlatIndex access = pop();
+            return add(FlatKind::_identifier_call, {.a = access, .b = call});
+        }
+
+        case FlattenStep::_function_call: {
+            NodeFunctionCall* call = static_cast<NodeFunctionCall*>(task.node);
+            FlatIndex count = static_cast<FlatIndex>(call->_arguments.size());
+            FlatIndex first = popList(count);
+            FlatIndex identifier = pop();
+            return add(FlatKind::_function_call, {.a = identifier, .b = first, .c = count});
+        }
+
+        case FlattenStep::_call:
+            return add(FlatKind::_call, {.a = pop()});
+
+        case FlattenStep::_assign: {
+            NodeAssign* assign = static_cast<NodeAssign*>(task.node);
+            FlatIndex rhs = pop();
+            FlatIndex lhs = pop();
+            FlatIndex op = assign->_operator ? copyToken(assign->_operator->_token) : NO_TOKEN;
+            return add(FlatKind::_assign, {.token = op, .a = lhs, .b = rhs});
+        }
+
+        case FlattenStep::_argument: {
+            NodeFunctionDeclerationArgument* argument = static_cast<NodeFunctionDeclerationArgument*>(task.node);
+            FlatIndex identifier = pop();
+            FlatIndex type = pop();
+            FlatIndex qualifier = argument->_qualifier ? copyToken(argument->_qualifier->_token) : NO_TOKEN;
+            return add(FlatKind::_argument, {.token = qualifier, .a = type, .b = identifier});
+        }
+
+        default:
+            return NO_NODE;
+        }
+    }
+
+public:
+    FlatAst() {}
+
+    explicit FlatAst(NodeProgram* program) {
+        if (!program) return;
+
+        for (NodeProgramElement* element : program->_elements) {
+            m_results.push_back(flatten(FlattenStep::_element, element));
+        }
+        m_root_count = static_cast<FlatIndex>(program->_elements.size());
+        m_root_first = popList(m_root_count);
+
+        // only needed while building
+        m_tasks = {};
+        m_results = {};
+    }
+
+    FlatKind kind(FlatIndex node) const {
+        return m_kinds[node];
+    }
+
+    const FlatNode& node(FlatIndex node) const {
+        return m_nodes[node];
+    }
+
+    // the token of `node`, nullptr when it has none
+    const Token* token(FlatIndex node) const {
+        FlatIndex token = m_nodes[node].token;
+        return token == NO_TOKEN ? nullptr : &m_tokens[token];
+    }
+
+    const Token* tokenAt(FlatIndex token) const {
+        return token == NO_TOKEN ? nullptr : &m_tokens[token];
+    }
+
+    // the m_extra range [first, first + count)
+    std::span<const FlatIndex> children(FlatIndex first, FlatIndex count) const {
+        if (count == 0 || count == NO_NODE) return {};
+        return std::span<const FlatIndex>(m_extra.data() + first, count);
+    }
+
+    // list operands of `node`, for every kind that keeps its children in [b, b + c)
+    std::span<const FlatIndex> children(FlatIndex node) const {
+        return children(m_nodes[node].b, m_nodes[node].c);
+    }
+
+    std::span<const FlatIndex> elements() const {
+        return children(m_root_first, m_root_count);
+    }
+
+    int64_t integerValue(FlatIndex node) const {
+        const FlatNode& integer = m_nodes[node];
+        return static_cast<int64_t>(static_cast<uint64_t>(integer.a) | (static_cast<uint64_t>(integer.b) << 32));
+    }
+
+    // _function and _procedure: return type, body statement and body expression
+    FlatIndex returnType(FlatIndex function) const {
+        return m_extra[m_nodes[function].b + m_nodes[function].c];
+    }
+
+    FlatIndex bodyStatement(FlatIndex function) const {
+        return m_extra[m_nodes[function].b + m_nodes[function].c + 1];
+    }
+
+    FlatIndex bodyExpression(FlatIndex function) const {
+        return m_extra[m_nodes[function].b + m_nodes[function].c + 2];
+    }
+
+    std::size_t size() const {
+        return m_nodes.size();
+    }
+
+    // bytes held by the four arrays, not counting unused capacity
+    std::size_t bytes() const {
+        return m_kinds.size() * sizeof(FlatKind) + m_nodes.size() * sizeof(FlatNode) +
+            m_extra.size() * sizeof(FlatIndex) + m_tokens.size() * sizeof(Token);
+    }
+};
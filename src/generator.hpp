@@ -1,10 +1,9 @@
 #pragma once
 #include "./tokenization.hpp"
 #include "./parser.hpp"
+#include "./flat_ast.hpp"
 #include <algorithm>
 
-#define DEBUG 1
-
 struct LoopContext {
     int loop_id;
 };
@@ -13,8 +12,11 @@ class Generator
 {
 private:
     NodeProgram *m_program;
+    // the program as walked by the generator
+    FlatAst m_ast;
     std::stringstream m_output_stream;
-    std::vector<std::unordered_map<std::string, int>> m_scopes;
+    // per scope, SymbolId of each variable -> frame offset
+    std::vector<std::unordered_map<SymbolId, int>> m_scopes;
 
     int m_local_size = 0;
     int m_temp_size = 0;
@@ -26,29 +28,36 @@ private:
     std::vector<LoopContext> m_loop_stack;
     std::unordered_map<std::string, std::pair<int, int>> m_func_decl_stack;
     int m_has_explicit_return = false;
+    // blocks, ifs and loops are generated recursively, this bounds how deep
+    int m_statement_depth = 0;
+    static constexpr int MAX_STATEMENT_DEPTH = 1000;
 
 public:
-    Generator(NodeProgram *program)
+    Generator(NodeProgram *program) : Generator(FlatAst(program), program) {}
+
+    // `program` is only printed at debug level, an AST loaded from an AstCache has none
+    Generator(FlatAst ast, NodeProgram *program = nullptr)
     {
-        printDebug("================= Generator ===============");
+        LOG_DEBUG("================= Generator ===============");
         m_program = program;
+        m_ast = std::move(ast);
     }
 
     void push_scope()
     {
-        printDebug("pushing scope::");
+        LOG_DEBUG("pushing scope::");
         m_scopes.emplace_back();
         m_current_scope = static_cast<int>(m_scopes.size()) - 1;
     }
 
     void pop_scope()
     {
-        printDebug("popping scope::");
+        LOG_DEBUG("popping scope::");
         if (!m_scopes.empty())
         {
-            printDebug(std::to_string(m_scopes.size()));
+            LOG_DEBUG(std::to_string(m_scopes.size()));
             m_scopes.pop_back();
-            printDebug(std::to_string(m_scopes.size()));
+            LOG_DEBUG(std::to_string(m_scopes.size()));
             m_current_scope = static_cast<int>(m_scopes.size()) - 1;
         }
         else
@@ -59,7 +68,7 @@ public:
 
     void generate()
     {
-        printDebug("cp2");
+        LOG_DEBUG("cp2");
         generateProgram(m_program);
 
         // output the assembly code to a file
@@ -68,33 +77,46 @@ public:
             ofile << m_output_stream.str();
         }
 
-        printDebug("================= Generation complete ===============");
+        LOG_INFO("Generation complete");
     }
 
-    // output the assembly code to std output and to output.s
+    // output the assembly code to output.s, and to the log at debug level
     void emit(const std::string &s, std::string comment = "", int indent = 0)
     {
         if (m_count_only)
             return;
 
+        std::string line;
         if (s.size())
         {
-            std::cout << getDebugPrefix(indent) << s;
-            m_output_stream << getDebugPrefix(indent) << s;
+            line = getDebugPrefix(indent) + s;
 
             if (comment.size())
             {
-                std::cout << "            // " << comment;
-                m_output_stream << "            // " << comment;
+                line += "            // " + comment;
             }
+        }
+
+        m_output_stream << line << '\n';
+        LOG_RAW(LogLevel::debug, line);
+    }
 
-            std::cout << std::endl;
-            m_output_stream << std::endl;
+    // loads a 64-bit constant, values that do not fit a single mov are built 16 bits at a time
+    void load_immediate(std::string _register, int64_t value, int indent = 0)
+    {
+        uint64_t bits = static_cast<uint64_t>(value);
+        if (bits <= 0xffff)
+        {
+            emit("mov " + _register + ", #" + std::to_string(bits), "store the integer in " + _register, indent);
+            return;
         }
-        else
+
+        emit("movz " + _register + ", #" + std::to_string(bits & 0xffff), "store the integer in " + _register, indent);
+        for (int shift = 16; shift < 64; shift += 16)
         {
-            std::cout << std::endl;
-            m_output_stream << std::endl;
+            uint64_t part = (bits >> shift) & 0xffff;
+            if (part)
+                emit("movk " + _register + ", #" + std::to_string(part) + ", lsl #" + std::to_string(shift), "", indent);
         }
     }
 
@@ -155,364 +177,364 @@ public:
         return output.str();
     }
 
-    void generateExpression(NodeExpression *expression, int indent)
+    /*
+        Generates `expression` into x0. Operands are walked with a work
+        stack rather than recursion, so a long chain like 1 + 1 + ... + 1
+        can not overflow the call stack. `step` counts the operands of a
+        node already generated, the node is revisited after each one.
+    */
+    void generateExpression(FlatIndex expression, int indent)
     {
-        printDebug("expr variant index = " + std::to_string(expression->_expression.index()));
-
-        if (!expression)
-        {
-            printDebug("null expression encountered in generateExpression");
-        }
+        struct ExpressionStep {
+            FlatIndex expression;
+            int step;
+        };
+        std::vector<ExpressionStep> work{{expression, 0}};
 
-        // generate integer literal
-        if (std::holds_alternative<NodeInteger *>(expression->_expression))
+        while (!work.empty())
         {
+            auto [expression, step] = work.back();
+            work.pop_back();
 
-            NodeInteger *node_integer = std::get<NodeInteger *>(expression->_expression);
-            if (!node_integer)
-                printError("Null NodeInteger");
-            emit("");
-            emit("mov x0, #" + std::to_string(node_integer->_value), "store the integer in x0", indent);
-
-            return;
-        }
-
-        // generate a unary expression
-        else if (std::holds_alternative<NodeExpressionUnary *>(expression->_expression))
-        {
-            NodeExpressionUnary *node_expression_unary = std::get<NodeExpressionUnary *>(expression->_expression);
-            generateExpression(node_expression_unary->_expression, indent);
-
-            switch (node_expression_unary->_operator->_token->getTokenType())
+            if (expression == NO_NODE)
             {
-            case TokenType::_unary_minus:
-                printDebug("found unary minus");
-                emit("neg x0, x0", "store in x0 negation of x0", indent);
-                break;
-
-            case TokenType::_not:
-                printDebug("found unary not");
-                emit("");
-                emit("cmp x0, #0", "set flags: Z=1 if x0 == x0", indent);
-                emit("cset x0, eq", "x0 = (x0 == 0) ? 1 : 0", indent);
-                break;
-
-            case TokenType::_unary_plus:
-                printDebug("found unary plus");
-                break;
-
-            default:
-                printError("invalid unary operator");
+                LOG_DEBUG("null expression encountered in generateExpression");
+                printError("Invalid expression variant");
             }
-        }
 
-        // generate a binary expression
-        else if (std::holds_alternative<NodeExpressionBinary *>(expression->_expression))
-        {
-            NodeExpressionBinary *node_expression_binary = std::get<NodeExpressionBinary *>(expression->_expression);
-            if (!node_expression_binary)
-                printError("Null NodeExpressionBinary");
-
-            // generate and store lhs
-            generateExpression(node_expression_binary->_lhs, indent);
-            push_temp("x0", indent);
-
-            // generate and store rhs
-            generateExpression(node_expression_binary->_rhs, indent);
-            pop_temp("x1", indent);
-
-            // arithmetic
-            NodeOperator *node_operator = node_expression_binary->_operator;
-            if (!node_operator)
-                printError("Null NodeOperator");
+            FlatKind kind = m_ast.kind(expression);
+            const FlatNode &node = m_ast.node(expression);
+            if (step == 0)
+                LOG_DEBUG("expr kind = " + std::to_string(static_cast<int>(kind)));
 
-            switch (node_operator->_token->getTokenType())
+            // generate integer literal
+            if (kind == FlatKind::_integer)
             {
-            case TokenType::_greater_than_equal:
-                emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, ge", "set x0 to the result", indent);
-                // printError("found >=");
-                break;
-
-            case TokenType::_greater_than:
-                emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, gt", "set x0 to the result", indent);
-                // printError("found >");
-                break;
-
-            case TokenType::_less_than_equal:
-                emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, le", "set x0 to the result", indent);
-                // printError("found <=");
-                break;
-
-            case TokenType::_less_than:
-                emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, lt", "set x0 to the result", indent);
-                // printError("found <");
-                break;
-
-            case TokenType::_check_equal:
-                emit("cmp x0, x1", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, eq", "set x0 to the result", indent);
-                // printError("found ==");
-                break;
-
-            case TokenType::_asterisk:
-                emit("mul x0, x1, x0", "x0 = x1 * x0", indent);
-                break;
-
-            case TokenType::_fwd_slash:
                 emit("");
-                emit("div x0, x1, x0", "x0 = x1 / x0", indent);
-                break;
+                load_immediate("x0", m_ast.integerValue(expression), indent);
+            }
 
-            case TokenType::_binary_plus:
-                emit("");
-                emit("add x0, x1, x0", "x0 = x1 + x0", indent);
-                break;
+            // generate a unary expression, operand first
+            else if (kind == FlatKind::_unary)
+            {
+                if (step == 0)
+                {
+                    work.push_back({expression, 1});
+                    work.push_back({node.a, 0});
+                }
+                else
+                {
+                    generateUnaryOperator(expression, indent);
+                }
+            }
 
-            case TokenType::_binary_minus:
-                emit("");
-                emit("sub x0, x1, x0", "x0 = x1 - x0", indent);
-                break;
+            // generate a binary expression
+            else if (kind == FlatKind::_binary)
+            {
+                if (step == 0)
+                {
+                    // generate lhs
+                    work.push_back({expression, 1});
+                    work.push_back({node.a, 0});
+                }
+                else if (step == 1)
+                {
+                    // store lhs, generate rhs
+                    push_temp("x0", indent);
+                    work.push_back({expression, 2});
+                    work.push_back({node.b, 0});
+                }
+                else
+                {
+                    pop_temp("x1", indent);
+                    generateBinaryOperator(expression, indent);
+                }
+            }
 
-            case TokenType::_or:
-                emit("");
-                emit("cmp x0, #0", "compare if x0 is not 0 and set a flag", indent);
-                emit("cset x0, ne", "set x0 to the result", indent);
+            // arguments go through the temporaries into x0..x7, then `bl`
+            else if (kind == FlatKind::_function_call)
+            {
+                std::span<const FlatIndex> arguments = m_ast.children(expression);
+                int argc = static_cast<int>(arguments.size());
 
-                emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
-                emit("cset x1, ne", "set x1 to the result", indent);
+                if (step == 0)
+                {
+                    baseIdentName(node.a);
+                    if (argc > 8) printError("More than 8 function arguments not supported");
+                }
+                else
+                {
+                    push_temp("x0", indent);
+                }
 
-                emit("orr x0, x1, x0", "x0 = x1 | x0", indent);
-                break;
+                if (step < argc)
+                {
+                    work.push_back({expression, step + 1});
+                    work.push_back({arguments[step], 0});
+                    continue;
+                }
 
-            case TokenType::_xor:
-                emit("");
-                emit("cmp x0, #0", "compare if x0 is 0 and set a flag", indent);
-                emit("cset x0, eq", "set x0 to the result", indent);
+                for (int i = argc - 1; i >= 0; i--) {
+                    pop_temp("x" + std::to_string(i), indent);
+                }
 
-                emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
-                emit("cset x1, eq", "set x1 to the result", indent);
+                std::string fn_name(baseIdentName(node.a));
+                emit("bl " + fn_name, "call " + fn_name, indent);
+            }
 
-                emit("eor x0, x0, x1", "", indent);
-                break;
+            // generate assign expression
+            else if (kind == FlatKind::_assign)
+            {
+                printError("found node assign");
+            }
 
-            case TokenType::_and:
-                emit("");
-                emit("cmp x0, #0", "compare if x0 is not 0 and set a flag", indent);
-                emit("cset x0, ne", "set x0 to the result", indent);
+            // generate identifier
+            else if (kind == FlatKind::_identifier || kind == FlatKind::_identifier_tuple || kind == FlatKind::_identifier_index || kind == FlatKind::_identifier_call)
+            {
+                if (node.a != NO_NODE) {
+                    printError("member access identifier not supported yet in expression");
+                }
 
-                emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
-                emit("cset x1, ne", "set x1 to the result", indent);
+                LOG_DEBUG("identifier kind = " + std::to_string(static_cast<int>(kind)));
 
-                emit("and x0, x0, x1", "", indent);
-                break;
+                if (kind == FlatKind::_identifier) {
+                    if (!m_ast.token(expression)) printError("null NodeIdentifierToken* in identifier expression");
+                    int offset = lookup(m_ast.token(expression)->getSymbol());
+                    peak("x0", offset, indent);
+                }
+                else if (kind == FlatKind::_identifier_call) {
+                    if (node.b == NO_NODE) printError("null NodeFunctionCall* in identifier expression");
+                    work.push_back({node.b, 0});
+                }
+                else {
+                    printError("unsupported identifier form in expression");
+                }
+            }
 
-            default:
-                printError("Invalid binary expression");
+            else
+            {
+                printError("Invalid expression variant");
             }
         }
+    }
 
-        else if (std::holds_alternative<NodeFunctionCall*>(expression->_expression)) {
-            NodeFunctionCall* fc = std::get<NodeFunctionCall*>(expression->_expression);
-            if (!fc) printError("null NodeFunctionCall");
+    // the operator of a unary expression, applied to x0
+    void generateUnaryOperator(FlatIndex expression, int indent)
+    {
+        if (!m_ast.token(expression))
+            printError("invalid unary operator");
 
-            std::string fn_name = baseIdentName(fc->_identifier);
+        switch (m_ast.token(expression)->getTokenType())
+        {
+        case TokenType::_unary_minus:
+            LOG_DEBUG("found unary minus");
+            emit("neg x0, x0", "store in x0 negation of x0", indent);
+            break;
 
-            int argc = (int)fc->_arguments.size();
-            if (argc > 8) printError("More than 8 function arguments not supported");
+        case TokenType::_not:
+            LOG_DEBUG("found unary not");
+            emit("");
+            emit("cmp x0, #0", "set flags: Z=1 if x0 == x0", indent);
+            emit("cset x0, eq", "x0 = (x0 == 0) ? 1 : 0", indent);
+            break;
 
-            for (int i = 0; i < argc; i++) {
-                generateExpression(fc->_arguments[i]->_expression, indent);
-                push_temp("x0", indent);
-            }
-            for (int i = argc - 1; i >= 0; i--) {
-                pop_temp("x" + std::to_string(i), indent);
-            }
+        case TokenType::_unary_plus:
+            LOG_DEBUG("found unary plus");
+            break;
 
-            emit("bl " + fn_name, "call " + fn_name, indent);
-            return;
+        default:
+            printError("invalid unary operator");
         }
+    }
 
+    // the operator of a binary expression, lhs in x1 and rhs in x0
+    void generateBinaryOperator(FlatIndex expression, int indent)
+    {
+        // arithmetic
+        const Token *node_operator = m_ast.token(expression);
+        if (!node_operator)
+            printError("Null NodeOperator");
+
+        switch (node_operator->getTokenType())
+        {
+        case TokenType::_greater_than_equal:
+            emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, ge", "set x0 to the result", indent);
+            // printError("found >=");
+            break;
+
+        case TokenType::_greater_than:
+            emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, gt", "set x0 to the result", indent);
+            // printError("found >");
+            break;
+
+        case TokenType::_less_than_equal:
+            emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, le", "set x0 to the result", indent);
+            // printError("found <=");
+            break;
+
+        case TokenType::_less_than:
+            emit("cmp x1, x0", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, lt", "set x0 to the result", indent);
+            // printError("found <");
+            break;
+
+        case TokenType::_check_equal:
+            emit("cmp x0, x1", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, eq", "set x0 to the result", indent);
+            // printError("found ==");
+            break;
+
+        case TokenType::_asterisk:
+            emit("mul x0, x1, x0", "x0 = x1 * x0", indent);
+            break;
+
+        case TokenType::_fwd_slash:
+            emit("");
+            emit("div x0, x1, x0", "x0 = x1 / x0", indent);
+            break;
 
-        // generate assign expression
-        else if (std::holds_alternative<NodeAssign *>(expression->_expression))
-        {
-            NodeAssign *node_assign = std::get<NodeAssign *>(expression->_expression);
-            generateExpression(node_assign->_rhs, indent);
-            printError("found node assign");
-        }
+        case TokenType::_binary_plus:
+            emit("");
+            emit("add x0, x1, x0", "x0 = x1 + x0", indent);
+            break;
 
-        // generate identifier
-        else if (std::holds_alternative<NodeIdentifier *>(expression->_expression))
-        {
-            NodeIdentifier *id = std::get<NodeIdentifier *>(expression->_expression);
-            if (!id) printError("null NodeIdentifier in identifier expression");
+        case TokenType::_binary_minus:
+            emit("");
+            emit("sub x0, x1, x0", "x0 = x1 - x0", indent);
+            break;
 
-            if (id->_access_token) {
-                printError("member access identifier not supported yet in expression");
-            }
+        case TokenType::_or:
+            emit("");
+            emit("cmp x0, #0", "compare if x0 is not 0 and set a flag", indent);
+            emit("cset x0, ne", "set x0 to the result", indent);
 
-            printDebug("NodeIdentifier::_identifier index = " + std::to_string(id->_identifier.index()));
+            emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
+            emit("cset x1, ne", "set x1 to the result", indent);
 
-            std::visit([&](auto* inner) {
-                using T = std::decay_t<decltype(inner)>;
+            emit("orr x0, x1, x0", "x0 = x1 | x0", indent);
+            break;
 
-                if constexpr (std::is_same_v<T, NodeIdentifierToken*>) {
-                    if (!inner) printError("null NodeIdentifierToken* in identifier expression");
-                    std::string name = inner->_token->getStrValue();
-                    int offset = lookup(name);
-                    peak("x0", offset, indent);
-                    return;
-                }
-                else if constexpr (std::is_same_v<T, NodeFunctionCall*>) {
-                    NodeFunctionCall* fc = inner;
-                    if (!fc) printError("null NodeFunctionCall* in identifier expression");
+        case TokenType::_xor:
+            emit("");
+            emit("cmp x0, #0", "compare if x0 is 0 and set a flag", indent);
+            emit("cset x0, eq", "set x0 to the result", indent);
 
-                    std::string fn_name = baseIdentName(fc->_identifier);
+            emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
+            emit("cset x1, eq", "set x1 to the result", indent);
 
-                    int argc = (int)fc->_arguments.size();
-                    if (argc > 8) printError("More than 8 function arguments not supported");
+            emit("eor x0, x0, x1", "", indent);
+            break;
 
-                    for (int i = 0; i < argc; i++) {
-                        generateExpression(fc->_arguments[i]->_expression, indent);
-                        push_temp("x0", indent);
-                    }
-                    for (int i = argc - 1; i >= 0; i--) {
-                        pop_temp("x" + std::to_string(i), indent);
-                    }
+        case TokenType::_and:
+            emit("");
+            emit("cmp x0, #0", "compare if x0 is not 0 and set a flag", indent);
+            emit("cset x0, ne", "set x0 to the result", indent);
 
-                    emit("bl " + fn_name, "call " + fn_name, indent);
-                    return;
-                }
-                else {
-                    printError(std::string("unsupported identifier form in expression (alt typeid=")
-                            + typeid(T).name() + ")");
-                }
-            }, id->_identifier);
+            emit("cmp x1, #0", "compare x1 with 0 and set a flag", indent);
+            emit("cset x1, ne", "set x1 to the result", indent);
 
-            return;
-        }
+            emit("and x0, x0, x1", "", indent);
+            break;
 
-        else
-        {
-            printError("Invalid expression variant");
+        default:
+            printError("Invalid binary expression");
         }
-        return;
     }
 
-    int lookup(const std::string &name)
+    int lookup(SymbolId symbol)
     {
         for (int i = m_scopes.size() - 1; i >= 0; --i)
         {
-            auto it = m_scopes[i].find(name);
+            auto it = m_scopes[i].find(symbol);
             if (it != m_scopes[i].end())
                 return it->second;
         }
-        printError("use of undeclared variable '" + name + "'");
+        printError("use of undeclared variable '" + std::string(SymbolTable::global().name(symbol)) + "'");
         return -1;
     }
 
-    void generateDecleration(NodeDecleration *decleration, int indent)
+    void generateDecleration(FlatIndex decleration, int indent)
     {
+        const FlatNode &node = m_ast.node(decleration);
+
         // print qualifier
-        if (decleration->_qualifier)
+        if (node.token != NO_TOKEN)
         {
-            printDebug("[has qualifier]");
+            LOG_DEBUG("[has qualifier]");
         }
         else
         {
-            printDebug("[No qualifier]");
+            LOG_DEBUG("[No qualifier]");
         }
 
         // print type
-        if (std::holds_alternative<Token *>(decleration->_type))
+        FlatKind type_kind = node.a == NO_NODE ? FlatKind::_decleration : m_ast.kind(node.a);
+        if (type_kind == FlatKind::_type)
         {
-            Token *token = std::get<Token *>(decleration->_type);
-            if (token != nullptr)
-            {
-                printDebug("Generating type token");
-                // printDebug(token->getStrValue());
-            }
+            LOG_DEBUG("Generating type token");
         }
-        else if (std::holds_alternative<NodeTypeTuple *>(decleration->_type))
+        else if (type_kind == FlatKind::_type_tuple)
         {
-            NodeTypeTuple *node_type_tuple = std::get<NodeTypeTuple *>(decleration->_type);
-            if (node_type_tuple != nullptr)
-            {
-                printDebug("Generating node_type_tuple");
-                // printTupleType(node_type_tuple, indent);
-            }
+            LOG_DEBUG("Generating node_type_tuple");
         }
-        else if (std::holds_alternative<NodeType *>(decleration->_type))
+        else if (type_kind == FlatKind::_type_vector || type_kind == FlatKind::_type_array)
         {
-            NodeType *node_type = std::get<NodeType *>(decleration->_type);
-            if (node_type != nullptr)
-            {
-                printDebug("Generating type");
-                // printType(node_type, indent);
-            }
+            LOG_DEBUG("Generating type");
         }
         else
         {
-            printDebug("[No type]");
+            LOG_DEBUG("[No type]");
         }
 
-        if (std::holds_alternative<NodeStruct *>(decleration->_type) && std::get<NodeStruct *>(decleration->_type))
+        if (type_kind == FlatKind::_struct)
         {
-            printDebug("Passes struct");
-
-            NodeStruct *node_struct = std::get<NodeStruct *>(decleration->_type);
-            if (node_struct != nullptr)
-            {
-                printDebug("generating struct");
-                // printStruct(node_struct, indent);
-            }
+            LOG_DEBUG("Passes struct");
+            LOG_DEBUG("generating struct");
         }
 
         // print identifier
-        else if (decleration->_identifier)
+        else if (node.b != NO_NODE)
         {
 
-            printDebug("generating identifier");
-            NodeIdentifier *node_identifier = decleration->_identifier;
-            NodeIdentifierToken* node_identifier_token = requireIdentToken(node_identifier, "declaration identifier");
+            LOG_DEBUG("generating identifier");
+            const Token *node_identifier_token = requireIdentToken(node.b, "declaration identifier");
 
-            std::string identifier_name = node_identifier_token->_token->getStrValue();
-            printDebug(std::to_string(m_scopes.size()));
+            SymbolId identifier_symbol = node_identifier_token->getSymbol();
+            LOG_DEBUG(std::to_string(m_scopes.size()));
             int offset;
 
             // redecleration check
-            if (m_scopes.size() > m_current_scope && m_scopes[m_current_scope].contains(identifier_name))
+            if (m_scopes.size() > m_current_scope && m_scopes[m_current_scope].contains(identifier_symbol))
             {
-                printError("redecleration of variable not allowed: " + identifier_name);
+                printError("redecleration of variable not allowed: " + std::string(node_identifier_token->getStrValue()));
             }
             else
             {
-                printDebug("cs1::" + std::to_string(m_current_scope) + "::" + std::to_string(m_local_size));
+                LOG_DEBUG("cs1::" + std::to_string(m_current_scope) + "::" + std::to_string(m_local_size));
                 m_local_size += 8;
                 
-                printDebug("cs1::" + std::to_string(m_current_scope) + "::" + std::to_string(m_local_size));
-                m_scopes[m_current_scope][identifier_name] = m_local_size;
-                printDebug(node_identifier_token->_token->getStrValue() + "::" + std::to_string(m_local_size));
+                LOG_DEBUG("cs1::" + std::to_string(m_current_scope) + "::" + std::to_string(m_local_size));
+                m_scopes[m_current_scope][identifier_symbol] = m_local_size;
+                LOG_DEBUG(std::string(node_identifier_token->getStrValue()) + "::" + std::to_string(m_local_size));
             }
             
-            if (decleration->_expression != NULL)
+            if (node.c != NO_NODE)
             {
-                printDebug("generating expression");
-                generateExpression(decleration->_expression, indent);
+                LOG_DEBUG("generating expression");
+                generateExpression(node.c, indent);
                 emit("// expression generated");
                 if (!m_count_only) {
-                    offset = lookup(identifier_name);
-                    printDebug("a::" + std::to_string(offset));
+                    offset = lookup(identifier_symbol);
+                    LOG_DEBUG("a::" + std::to_string(offset));
                     store_var("x0", offset, indent);
                 }
             }
             else
             {
-                printDebug("[No expression]");
+                LOG_DEBUG("[No expression]");
             }
         }
         else
@@ -526,48 +548,56 @@ public:
         return m_label_count++;
     }
 
-    NodeIdentifierToken* requireIdentToken(NodeIdentifier* id, const std::string& ctx) {
-        if (!id) printError("null identifier in " + ctx);
+    const Token* requireIdentToken(FlatIndex id, const std::string& ctx) {
+        if (id == NO_NODE) printError("null identifier in " + ctx);
 
-        if (auto p = std::get_if<NodeIdentifierToken*>(&id->_identifier)) {
-            if (!*p) printError("null NodeIdentifierToken* in " + ctx);
-            return *p;
+        if (m_ast.kind(id) == FlatKind::_identifier) {
+            if (!m_ast.token(id)) printError("null NodeIdentifierToken* in " + ctx);
+            return m_ast.token(id);
         }
 
         printError("expected simple identifier token in " + ctx);
         return nullptr;
     }
 
-    std::string baseIdentName(NodeIdentifier* id) {
-        return requireIdentToken(id, "baseIdentName")-> _token->getStrValue();
+    std::string_view baseIdentName(FlatIndex id) {
+        return requireIdentToken(id, "baseIdentName")->getStrValue();
     }
 
-    void generateStatement(NodeStatement *statement, int indent)
+    void generateStatement(FlatIndex statement, int indent)
     {
+        if (statement == NO_NODE)
+            printError("Unexpected statement encountered during print");
+
+        if (++m_statement_depth > MAX_STATEMENT_DEPTH)
+            printError("Statements nested more than " + std::to_string(MAX_STATEMENT_DEPTH) + " levels deep are not supported");
 
-        if (std::holds_alternative<NodeDecleration *>(statement->_statement))
+        FlatKind kind = m_ast.kind(statement);
+        const FlatNode &node = m_ast.node(statement);
+
+        if (kind == FlatKind::_decleration)
         {
-            printDebug("Generating NodeDecleration");
-            generateDecleration(std::get<NodeDecleration *>(statement->_statement), indent);
+            LOG_DEBUG("Generating NodeDecleration");
+            generateDecleration(statement, indent);
         }
 
-        else if (std::holds_alternative<NodeBlock *>(statement->_statement))
+        else if (kind == FlatKind::_block)
         {
-            printDebug("Generating NodeBlock");
-            NodeBlock *node_block = std::get<NodeBlock *>(statement->_statement);
+            LOG_DEBUG("Generating NodeBlock");
 
             push_scope();
-            for (NodeProgramElement *element : node_block->_elements)
+            for (FlatIndex element : m_ast.children(statement))
             {
                 generateElement(element, indent + 1);
             }
             pop_scope();
         }
 
-        else if (std::holds_alternative<NodeControl *>(statement->_statement))
+        else if (kind == FlatKind::_control)
         {
-            printDebug("Generating NodeControl");
-            NodeControl *node_control = std::get<NodeControl *>(statement->_statement);
+            LOG_DEBUG("Generating NodeControl");
+            // condition and statement pairs, the `if` first and then each `else if`
+            std::span<const FlatIndex> branches = m_ast.children(node.b, 2 * node.c);
             int id = genLabel();
 
             auto L = [&](const std::string& name) {
@@ -575,49 +605,47 @@ public:
             };
 
             // generate if
-            generateExpression(node_control->_if.first, indent);
+            generateExpression(branches[0], indent);
             emit("");
             emit("cmp x0, #0", "compare if x0 is 0 and set a flag", indent);
             emit("b.eq " + L("next"), "branch to else if res is 0", indent);
 
 
-            generateStatement(node_control->_if.second, indent);
+            generateStatement(branches[1], indent);
             emit("");
             emit("b " + L("end"), "branch to else after completing if", indent);
             emit(L("next") + ":", "", indent);
 
             // generate else if
             int else_if_count = 0;
-            for (int i = 0; i < node_control->_else_if.size(); i++) {
-                auto elif = node_control->_else_if[i];
-
-                generateExpression(elif.first, indent);
+            for (int i = 0; i + 1 < node.c; i++) {
+                generateExpression(branches[2 * i + 2], indent);
                 emit("");
                 emit("cmp x0, #0", "compare if x0 is 0 and set a flag", indent);
                 emit("b.eq .Lelifnext_" + std::to_string(id) + "_" + std::to_string(i), "branch to else if res is 0", indent);
 
-                generateStatement(elif.second, indent);
+                generateStatement(branches[2 * i + 3], indent);
                 emit("");
                 emit("b " + L("end"), "branch to else after completing else if", indent);
                 emit(".Lelifnext_" + std::to_string(id) + "_" + std::to_string(i) + ":", "", indent);
             }
             
             // generate else
-            if (node_control->_statement_else) {
+            if (node.a != NO_NODE) {
                 emit("");
-                generateStatement(node_control->_statement_else, indent);
+                generateStatement(node.a, indent);
                 emit("");
             }
 
             emit(L("end") + ":", "", indent);
             emit("// incremented branch count");
         }
-        else if (std::holds_alternative<NodeStatementToken *>(statement->_statement))
+        else if (kind == FlatKind::_statement_token)
         {
-            printDebug("Generating NodeStatementToken");
-            NodeStatementToken *node_statment_token = std::get<NodeStatementToken*>(statement->_statement);
+            LOG_DEBUG("Generating NodeStatementToken");
+            const Token *node_statment_token = m_ast.token(statement);
 
-            switch (node_statment_token->_token->getTokenType()) {
+            switch (node_statment_token->getTokenType()) {
                 
                 case TokenType::_break:
                     if (!m_loop_stack.size()) {
@@ -636,49 +664,48 @@ public:
                     break;
 
                 default:
-                    printError("Invalid token statement:" + node_statment_token->_token->getStrValue());
+                    printError("Invalid token statement:" + std::string(node_statment_token->getStrValue()));
                     break;
             }
         }
-        else if (std::holds_alternative<NodeStream *>(statement->_statement))
+        else if (kind == FlatKind::_stream)
         {
-            printDebug("Generating NodeStream");
+            LOG_DEBUG("Generating NodeStream");
             // todo
         }
-        else if (std::holds_alternative<NodeLoop *>(statement->_statement))
+        else if (kind == FlatKind::_loop)
         {
-            printDebug("Generating NodeLoop");
-            NodeLoop* node_loop = std::get<NodeLoop *>(statement->_statement);
+            LOG_DEBUG("Generating NodeLoop");
             int loop_id = 0;
             if (!m_count_only) loop_id = genLabel();
 
             emit("BeginLoop_" + std::to_string(loop_id) + ":", "", 1);
             m_loop_stack.push_back({ loop_id });
 
-            if (*node_loop->_predicated) {
-                printDebug("predicated");
+            if (node.c) {
+                LOG_DEBUG("predicated");
                 if (!m_count_only)
                     emit("LoopCondition_" + std::to_string(loop_id) + ":", "", indent);
     
-                generateExpression(node_loop->_expression, indent);
+                generateExpression(node.a, indent);
                 emit("cmp x0, #0", "", indent);
                 
                 if (!m_count_only)
                     emit("b.eq EndLoop_" + std::to_string(loop_id), "", indent);
 
-                generateStatement(node_loop->_statement, indent);
+                generateStatement(node.b, indent);
 
                 if (!m_count_only)
                     emit("b BeginLoop_" + std::to_string(loop_id), "", indent);
                 
-            } else if (node_loop->_expression) {
-                printDebug("postpredicated");
-                generateStatement(node_loop->_statement, indent);
+            } else if (node.a != NO_NODE) {
+                LOG_DEBUG("postpredicated");
+                generateStatement(node.b, indent);
                 
                 if (!m_count_only)
                     emit("LoopCondition_" + std::to_string(loop_id) + ":", "", indent);
     
-                generateExpression(node_loop->_expression, indent);
+                generateExpression(node.a, indent);
                 emit("cmp x0, #0", "", indent);
     
                 if (!m_count_only)
@@ -686,8 +713,8 @@ public:
 
 
             } else {
-                printDebug("infinite");
-                generateStatement(node_loop->_statement, indent);
+                LOG_DEBUG("infinite");
+                generateStatement(node.b, indent);
 
                 if (!m_count_only)
                     emit("b BeginLoop_" + std::to_string(loop_id), "", indent);
@@ -697,11 +724,10 @@ public:
             m_loop_stack.pop_back();
         }
 
-        else if (std::holds_alternative<NodeReturn *>(statement->_statement))
+        else if (kind == FlatKind::_return)
         {
-            printDebug("Generating NodeReturn");
-            NodeReturn *node_return = std::get<NodeReturn *>(statement->_statement);
-            generateExpression(node_return->_expression, indent);
+            LOG_DEBUG("Generating NodeReturn");
+            generateExpression(node.a, indent);
 
             emit("");
             emit("mov sp, x29", "restore sp from fp", indent);
@@ -711,45 +737,41 @@ public:
             m_has_explicit_return = true;
         }
 
-        else if (std::holds_alternative<NodeCall*>(statement->_statement)) {
-            NodeCall* c = std::get<NodeCall*>(statement->_statement);
+        else if (kind == FlatKind::_call) {
+            // node.a is the _function_call node
+            std::string fn_name(baseIdentName(m_ast.node(node.a).a));
 
-            // c->_function_call->_identifier holds NodeFunctionCall*
-            NodeFunctionCall* fc = c->_function_call;
-
-            std::string fn_name = baseIdentName(fc->_identifier);
-
-            int argc = (int)fc->_arguments.size();
+            std::span<const FlatIndex> arguments = m_ast.children(node.a);
+            int argc = (int)arguments.size();
             if (argc > 8) printError("More than 8 function arguments not supported");
 
             for (int i = 0; i < argc; i++) {
-                generateExpression(fc->_arguments[i]->_expression, indent);
+                generateExpression(arguments[i], indent);
                 emit("mov x" + std::to_string(i) + ", x0", "arg " + std::to_string(i), indent);
             }
 
             emit("bl " + fn_name, "call " + fn_name, indent);
         }
 
-        else if (std::holds_alternative<NodeAssign *>(statement->_statement))
+        else if (kind == FlatKind::_assign)
         {
-            printDebug("Generating NodeAssign");
-            NodeAssign *node_assign = std::get<NodeAssign *>(statement->_statement);
-            generateExpression(node_assign->_rhs, indent);
+            LOG_DEBUG("Generating NodeAssign");
+            generateExpression(node.b, indent);
 
             if (!m_count_only)
             {
-                NodeIdentifier *lhs_identifier = std::get<NodeIdentifier *>(node_assign->_lhs->_expression);
+                const Token *lhs_identifier_token = requireIdentToken(node.a, "assignment");
 
-                NodeIdentifierToken *lhs_identifier_token = std::get<NodeIdentifierToken *>(lhs_identifier->_identifier);
-
-                emit("str x0, [x29, #" + std::to_string(-lookup(lhs_identifier_token->_token->getStrValue())) + "]", "store the new value", indent);
+                emit("str x0, [x29, #" + std::to_string(-lookup(lhs_identifier_token->getSymbol())) + "]", "store the new value", indent);
             }
         }
         else
         {
-            printDebug("1");
-            printError("Unexpected statement encountered during print" + std::string(typeid(statement->_statement).name()));
+            LOG_DEBUG("1");
+            printError("Unexpected statement encountered during print");
         }
+
+        m_statement_depth--;
     }
 
     enum class FuncMode {
@@ -760,31 +782,32 @@ public:
 
     FuncMode m_mode = FuncMode::None;
 
-    void bindAndStoreParams(NodeFunctionDecleration* fn, int indent) {
+    void bindAndStoreParams(FlatIndex fn, int indent) {
         // Gazprea: function args implicitly const; procedures allow qualifiers
         const int MAX_REG_ARGS = 8;
-        int n = (int)fn->_arguments.size();
+        std::span<const FlatIndex> arguments = m_ast.children(fn);
+        int n = (int)arguments.size();
         if (n > MAX_REG_ARGS) printError("More than 8 args not supported yet");
 
         for (int i = 0; i < n; i++) {
-            auto* arg = fn->_arguments[i];
-            std::string name = baseIdentName(arg->_identifier);
+            FlatIndex arg = arguments[i];
+            SymbolId symbol = requireIdentToken(m_ast.node(arg).b, "baseIdentName")->getSymbol();
 
             // reserve slot
             m_local_size += 8;
 
             bool is_mut = false;
-            if (m_mode == FuncMode::Procedure && arg->_qualifier) {
-                auto qt = arg->_qualifier->_token->getTokenType();
+            if (m_mode == FuncMode::Procedure && m_ast.token(arg)) {
+                auto qt = m_ast.token(arg)->getTokenType();
                 if (qt == TokenType::_var) is_mut = true;
             }
             // functions: always const
             if (m_mode == FuncMode::Function) is_mut = false;
 
-            m_scopes[m_current_scope][name] = m_local_size;
+            m_scopes[m_current_scope][symbol] = m_local_size;
 
             if (!m_count_only) {
-                store_var("x" + std::to_string(i), m_scopes[m_current_scope][name], indent);
+                store_var("x" + std::to_string(i), m_scopes[m_current_scope][symbol], indent);
             }
         }
     }
@@ -801,27 +824,32 @@ public:
         emit("ret", "return", indent);
     }
 
-    void generateFunctionDecleration(NodeFunctionDecleration* node_function_decleration, int indent) {
+    void generateFunctionDecleration(FlatIndex node_function_decleration, int indent) {
         // TODO: assert that it is a global scope
  
-        NodeIdentifier* node_identifier = node_function_decleration->_identifier;
-        if (node_identifier->_access_token) printError("member function not implemented");
+        FlatIndex node_identifier = m_ast.node(node_function_decleration).a;
+        if (m_ast.node(node_identifier).a != NO_NODE) printError("member function not implemented");
 
-        NodeIdentifierToken* node_identifier_token = std::get<NodeIdentifierToken*>(node_identifier->_identifier);
-        std::string name = node_identifier_token->_token->getStrValue();
+        std::string name(requireIdentToken(node_identifier, "function decleration")->getStrValue());
+        bool is_procedure = m_ast.kind(node_function_decleration) == FlatKind::_procedure;
+        FlatIndex body_statement = m_ast.bodyStatement(node_function_decleration);
+        FlatIndex body_expression = m_ast.bodyExpression(node_function_decleration);
+
+        // a body the parser's lazy mode never reached, nothing calls it
+        if (body_statement == NO_NODE && body_expression == NO_NODE) return;
 
         // pass 1: count only
         resetFrameTracking();
         m_count_only = true;
-        m_mode = *node_function_decleration->is_procedure
+        m_mode = is_procedure
                 ? FuncMode::Procedure
                 : FuncMode::Function;
 
         push_scope();
         bindAndStoreParams(node_function_decleration, indent);
 
-        if (node_function_decleration->_statement) generateStatement(node_function_decleration->_statement, indent);
-        else generateExpression(node_function_decleration->_expression, indent);
+        if (body_statement != NO_NODE) generateStatement(body_statement, indent);
+        else generateExpression(body_expression, indent);
 
         pop_scope();
 
@@ -837,24 +865,24 @@ public:
         emit(name + ":");
         emitPrologue(fn_frame, indent);
 
-        m_mode = *node_function_decleration->is_procedure
+        m_mode = is_procedure
                 ? FuncMode::Procedure
                 : FuncMode::Function;
 
         push_scope();
         bindAndStoreParams(node_function_decleration, indent);
 
-        if (node_function_decleration->_statement) {
+        if (body_statement != NO_NODE) {
             // implicit fallthrough return for procedures
-            if (node_function_decleration->_statement) {
-                generateStatement(node_function_decleration->_statement, indent);
+            if (body_statement != NO_NODE) {
+                generateStatement(body_statement, indent);
                 if (!m_has_explicit_return && m_mode == FuncMode::Procedure) {
                     emitEpilogue(indent);
                 }
             }
         } else {
             // expression body:
-            generateExpression(node_function_decleration->_expression, indent);
+            generateExpression(body_expression, indent);
             emitEpilogue(indent);
         }
 
@@ -863,25 +891,29 @@ public:
         m_mode = FuncMode::None;
     }
 
-    void generateElement(NodeProgramElement *element, int indent)
+    bool isFunction(FlatIndex element)
+    {
+        return element != NO_NODE && (m_ast.kind(element) == FlatKind::_function || m_ast.kind(element) == FlatKind::_procedure);
+    }
+
+    void generateElement(FlatIndex element, int indent)
     {
-        if (std::holds_alternative<NodeStatement *>(element->_element))
+        if (element == NO_NODE)
+            return;
+
+        if (isFunction(element))
         {
-            NodeStatement *statement = std::get<NodeStatement *>(element->_element);
-            printDebug("Generating statement");
-            generateStatement(statement, indent);
+            LOG_DEBUG("Generating functionDecleration");
+            generateFunctionDecleration(element, indent);
         }
-        else if (std::holds_alternative<NodeFunctionDecleration *>(element->_element))
+        else if (m_ast.kind(element) == FlatKind::_typealias)
         {
-            NodeFunctionDecleration *node_function_decleration = std::get<NodeFunctionDecleration *>(element->_element);
-            printDebug("Generating functionDecleration");
-            generateFunctionDecleration(node_function_decleration, indent);
+            printError("NodeTypealias not implemented");
         }
-        else if (std::holds_alternative<NodeTypealias *>(element->_element))
+        else
         {
-            NodeTypealias *node_typealias = std::get<NodeTypealias *>(element->_element);
-            printError("NodeTypealias not implemented");
-            // printTypealias(node_typealias, indent);
+            LOG_DEBUG("Generating statement");
+            generateStatement(element, indent);
         }
     }
 
@@ -898,26 +930,29 @@ public:
 
     void generateProgram(NodeProgram *program)
     {
-        printDebug("cp1");
+        // the printout comes from the pointer tree, everything else walks m_ast
+        LOG_DEBUG("cp1");
 
-        Parser Parser;
-        Parser.printProgram(program);
+        if (program && logEnabled(LogLevel::debug)) {
+            Parser Parser;
+            Parser.printProgram(program);
+        }
 
         int indent = 1;
 
         // Pass 1: count _main locals only
         resetFrameTracking();
         m_count_only = true;
-        for (auto e : program->_elements) {
-            if (std::holds_alternative<NodeFunctionDecleration*>(e->_element)) continue;
+        for (FlatIndex e : m_ast.elements()) {
+            if (isFunction(e)) continue;
             generateElement(e, indent);
         }
         m_frame_size = align16(m_local_size + m_max_temp_size);
 
         // Pass 2: emit functions
         m_count_only = false;
-        for (auto e : program->_elements) {
-            if (std::holds_alternative<NodeFunctionDecleration*>(e->_element)) generateElement(e, indent);
+        for (FlatIndex e : m_ast.elements()) {
+            if (isFunction(e)) generateElement(e, indent);
         }
 
         // Pass 2: emit _main
@@ -928,8 +963,8 @@ public:
         emitPrologue(m_frame_size, indent);
 
         push_scope();
-        for (auto e : program->_elements) {
-            if (std::holds_alternative<NodeFunctionDecleration*>(e->_element)) continue;
+        for (FlatIndex e : m_ast.elements()) {
+            if (isFunction(e)) continue;
             generateElement(e, indent);
         }
         pop_scope();
@@ -946,16 +981,4 @@ public:
     {
         throw std::runtime_error(std::string(RED) + error_msg + " at " + std::to_string(line) + ":" + std::to_string(_char) + "\033[0m");
     }
-
-    void printDebug(std::string msg)
-    {
-#if DEBUG
-        std::cout << std::string(CYAN) + "[debug] " + msg + "\033[0m" << std::endl;
-#endif
-    }
-
-    void printOk(std::string msg)
-    {
-        std::cout << std::string(GREEN) + "[ok] " + msg + "\033[0m" << std::endl;
-    }
 };
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "symbol.hpp"
+
+using LiteralId = uint32_t;
+
+constexpr LiteralId NO_LITERAL = UINT32_MAX;
+
+/*
+    Decoded string and character literals.
+
+    The tokenizer decodes the escapes of every `"..."` and `'...'` literal
+    once and stores the result here. Identical literals share one entry, so
+    tokens and AST nodes refer to a literal by its dense LiteralId and the
+    generator can emit one pooled entry per unique literal.
+
+    Storage and deduplication are the same as for identifier names, the
+    texts live in a SymbolTable of their own and keep their views valid for
+    the life of the program. Decoded text may contain `\0`.
+*/
+class LiteralTable {
+private:
+    SymbolTable m_texts;
+
+public:
+    static LiteralTable& global() {
+        static LiteralTable table;
+        return table;
+    }
+
+    LiteralId intern(std::string_view text) {
+        return m_texts.intern(text);
+    }
+
+    std::string_view text(LiteralId id) const {
+        return m_texts.name(id);
+    }
+
+    std::size_t size() const {
+        return m_texts.size();
+    }
+};
+
+// the character `\<escape>` stands for, nothing for an unknown escape
+inline std::optional<char> decodeEscape(char escape) {
+    switch (escape) {
+        case '0': return '\0';
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case '"': return '"';
+        case '\'': return '\'';
+        case '\\': return '\\';
+        default: return std::nullopt;
+    }
+}
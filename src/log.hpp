@@ -0,0 +1,58 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+
+#define CYAN    "\033[36m"
+#define GREEN   "\033[32m"
+#define YELLOW  "\033[33m"
+#define RED     "\033[31m"
+
+/*
+    Level-gated logging shared by the Tokenizer, Parser and Generator.
+
+    Messages go to stderr when their level is at or below the runtime level
+    set with setLogLevel(), which starts out as `quiet`. LOG_COMPILE_LEVEL is
+    the highest level compiled in at all, anything above it is removed by the
+    compiler. The LOG_* macros check the level before evaluating their
+    argument, so a disabled message never builds its string.
+
+    trace is meant for per-character and per-token chatter, debug for parser
+    and generator progress, the AST dump and the emitted assembly, info for
+    one line per compiler phase.
+*/
+enum class LogLevel : int {
+    quiet = 0,
+    info = 1,
+    debug = 2,
+    trace = 3,
+};
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 3
+#endif
+
+inline LogLevel g_log_level = LogLevel::quiet;
+
+inline void setLogLevel(LogLevel level) {
+    g_log_level = level;
+}
+
+inline bool logEnabled(LogLevel level) {
+    return static_cast<int>(level) <= LOG_COMPILE_LEVEL && level <= g_log_level;
+}
+
+// writes one finished line, a single write keeps lines whole when several threads log
+inline void logWrite(const char* prefix, const std::string& msg) {
+    std::cerr << (*prefix ? std::string(prefix) + msg + "\033[0m\n" : msg + "\n");
+}
+
+#define LOG_AT(level, prefix, msg) do { if (logEnabled(level)) logWrite(prefix, (msg)); } while (0)
+
+#define LOG_INFO(msg)  LOG_AT(LogLevel::info, GREEN "[info] ", msg)
+#define LOG_OK(msg)    LOG_AT(LogLevel::debug, GREEN "[ok] ", msg)
+#define LOG_DEBUG(msg) LOG_AT(LogLevel::debug, CYAN "[debug] ", msg)
+#define LOG_TRACE(msg) LOG_AT(LogLevel::trace, CYAN "[trace] ", msg)
+
+// lines printed as they are, without a prefix or colour
+#define LOG_RAW(level, msg) LOG_AT(level, "", msg)
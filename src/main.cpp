@@ -4,42 +4,126 @@
 #include <optional>
 #include <vector>
 
+#include "./source.hpp"
 #include "./tokenization.hpp"
 #include "./parser.hpp"
 #include "./generator.hpp"
+#include "./token_cache.hpp"
+#include "./ast_cache.hpp"
 
-void printDebug(std::string msg) {
-    #if DEBUG
-        std::cout << std::string(CYAN) + "[debug] " + msg + "\033[0m" << std::endl;
-    #endif
-}
+/*
+    usage: main.o [-q | -v | -vv | -vvv] [--token-cache] [--ast-cache] [--lazy-bodies] <file>
+
+    -v prints one line per compiler phase, -vv adds parser and generator
+    progress, the AST and the emitted assembly, -vvv adds per-token tracing.
+    Nothing is printed by default.
+
+    --token-cache reuses the tokens stored in <file>.gaztok when it matches
+    the source and this compiler, and writes it after lexing otherwise.
 
+    --ast-cache does the same with the parsed program in <file>.gazast, a
+    valid one skips both lexing and parsing.
+
+    --lazy-bodies parses only the bodies of the functions and procedures the
+    program can call, the others are not compiled.
+*/
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    const char* path = nullptr;
+    bool token_cache = false;
+    bool ast_cache = false;
+    bool lazy_bodies = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-q") {
+            setLogLevel(LogLevel::quiet);
+        } else if (arg == "-v") {
+            setLogLevel(LogLevel::info);
+        } else if (arg == "-vv") {
+            setLogLevel(LogLevel::debug);
+        } else if (arg == "-vvv") {
+            setLogLevel(LogLevel::trace);
+        } else if (arg == "--token-cache") {
+            token_cache = true;
+        } else if (arg == "--ast-cache") {
+            ast_cache = true;
+        } else if (arg == "--lazy-bodies") {
+            lazy_bodies = true;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+
+    if (!path) {
         std::cerr << "Incorrect number of parameters" << std::endl;
+        return 1;
     }
 
-    std::string content;
-    {
-        std::ifstream file(argv[1]);
-        if (!file) {
-            std::cerr << "File not found" << std::endl;
-            return 1;
+    // `-` reads the program from stdin
+    SourceFile source;
+    if (!source.open(path)) {
+        std::cerr << "File not found" << std::endl;
+        return 1;
+    }
+
+    // a valid precompiled AST replaces lexing and parsing, like the token cache below
+    std::optional<AstCache> precompiled;
+    if (ast_cache && std::string(path) != "-") {
+        precompiled.emplace(AstCache::pathFor(path), lazy_bodies);
+    }
+
+    if (precompiled) {
+        if (std::optional<FlatAst> ast = precompiled->load(source.content())) {
+            Generator generator(std::move(*ast));
+            generator.generate();
+            return EXIT_SUCCESS;
         }
+    }
+
+    // a valid cache replaces lexing, stdin has no file to keep one next to
+    std::optional<TokenCache> cache;
+    if (token_cache && std::string(path) != "-") {
+        cache.emplace(TokenCache::pathFor(path));
+    }
+
+    std::optional<std::vector<Token>> cached;
+    if (cache) {
+        cached = cache->load(source.content());
+    }
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        content = buffer.str(); 
+    // only made when lexing, it registers the source in SourceMap as a cache hit already has
+    std::optional<Tokenizer> tokenizer;
+    if (!cached) {
+        tokenizer.emplace(source.content());
     }
 
-    Tokenizer tokenizer(content);
-    std::vector<Token> tokens = tokenizer.tokenize();
+    // large inputs are lexed up front on every core, smaller ones are streamed into the parser
+    std::vector<Token> tokens;
+    bool lex_up_front = !cached && (cache || source.content().size() >= Tokenizer::PARALLEL_MIN_SIZE);
+    if (cached) {
+        tokens = std::move(*cached);
+    } else if (lex_up_front) {
+        tokens = tokenizer->tokenizeParallel();
+        if (cache) {
+            cache->save(source.content(), tokens);
+        }
+    }
 
-    Parser parser(tokens);
-    NodeProgram* program = parser.parse();
+    // tokens that are all here up front are also parsed on every core
+    Parser parser = cached || lex_up_front ? Parser(std::move(tokens)) : Parser(*tokenizer);
+    parser.setLazyBodies(lazy_bodies);
+    NodeProgram* program = cached || lex_up_front ? parser.parseParallel() : parser.parse();
+
+    LOG_DEBUG("cp3");
+    FlatAst ast(program);
+    if (precompiled) {
+        precompiled->save(source.content(), ast);
+    }
 
-    printDebug("cp3");
-    Generator generator(program);
+    Generator generator(std::move(ast), program);
     generator.generate();
 
     return EXIT_SUCCESS;
@@ -1,8 +1,12 @@
 #pragma once
+#include "./arena.hpp"
 #include "./tokenization.hpp"
+#include <algorithm>
 #include <variant>
 #include <typeinfo>
+#include <sstream>
 #include <unordered_map>
+#include <mutex>
 
 #define CYAN    "\033[36m"
 #define GREEN   "\033[32m"
@@ -35,17 +39,19 @@ struct NodeBoolean {
 
 struct NodeInteger {
     Token* _token;
-    int _value;
+    int64_t _value;
 };
 
 struct NodeCharacter {
     Token* _token;
-    std::string _value;
+    // entry in LiteralTable::global()
+    LiteralId _literal;
 };
 
 struct NodeString {
     Token* _token;
-    std::string _value;
+    // entry in LiteralTable::global()
+    LiteralId _literal;
 };
 
 struct NodeRange {
@@ -85,7 +91,7 @@ struct NodeStatementToken {
 };
 
 struct NodeLoop {
-    bool* _predicated;
+    bool _predicated;
     NodeExpression* _expression;
     NodeStatement* _statement;
 };
@@ -180,7 +186,10 @@ struct NodeFunctionDecleration {
     NodeType* _return_type;
     NodeStatement* _statement;
     NodeExpression* _expression;
-    bool* is_procedure;
+    bool is_procedure;
+    // token span of a body the parser's lazy mode has not parsed yet, empty once it has
+    std::size_t _body_start = 0;
+    std::size_t _body_end = 0;
 };
 
 struct NodeProgramElement {
@@ -216,42 +225,374 @@ struct NodeStatement {
     std::variant<NodeDecleration*, NodeBlock*, NodeControl*, NodeStatementToken*, NodeReturn*, NodeStream*, NodeLoop*, NodeCall*, NodeAssign*> _statement;
 };
 
+/*
+    Named types and interned type nodes for the Parser.
+
+    Every name declared as a type, by a struct, a typealias or a `Name name`
+    declaration, is registered under its SymbolId, so checking whether a
+    name is a type is one lookup however many declarations came before. An
+    alias maps straight to the type it names. Its target was parsed, and so
+    already resolved, when the alias was declared, so chains of aliases are
+    never followed again.
+
+    Type nodes are interned by structure: a name, an array of a given size,
+    a vector or a tuple of given element types is built once and returned
+    for every later occurrence, so two types are equal exactly when their
+    NodeType pointers are. An interned node keeps the tokens of the first
+    occurrence. New nodes come from the arena passed in, the Parser's.
+
+    The chunk parsers of Parser::parseParallel() intern into their parent's
+    registry, with interning locked while setShared(true). Names are only
+    read then, a chunk that could declare one is never parsed in parallel.
+*/
+class TypeRegistry {
+private:
+    enum class Form : uint8_t {
+        _name,
+        _array,
+        _vector,
+        _tuple,
+    };
+
+    struct Key {
+        Form form;
+        uint64_t first = 0;
+        uint64_t second = 0;
+        std::vector<const NodeType*> elements;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            std::size_t hash = static_cast<std::size_t>(key.form);
+            hash = hash * 31 + std::hash<uint64_t>()(key.first);
+            hash = hash * 31 + std::hash<uint64_t>()(key.second);
+            for (const NodeType* element : key.elements) {
+                hash = hash * 31 + std::hash<const NodeType*>()(element);
+            }
+            return hash;
+        }
+    };
+
+    struct Name {
+        bool declared = false;
+        NodeType* alias = nullptr;
+    };
+
+    // indexed by SymbolId
+    std::vector<Name> m_names;
+    std::unordered_map<Key, NodeType*, KeyHash> m_interned;
+    // guards m_interned while m_shared
+    mutable std::mutex m_mutex;
+    bool m_shared = false;
+
+    Name* find(const Token* token) {
+        SymbolId symbol = token->getSymbol();
+        return symbol < m_names.size() ? &m_names[symbol] : nullptr;
+    }
+
+    template <typename Make>
+    NodeType* intern(Key key, Make make) {
+        std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+        if (m_shared) lock.lock();
+
+        auto [it, inserted] = m_interned.try_emplace(std::move(key), nullptr);
+        if (inserted) {
+            it->second = make();
+        }
+        return it->second;
+    }
+
+    static uint64_t address(const NodeType* type) {
+        return reinterpret_cast<uintptr_t>(type);
+    }
+
+public:
+    void declare(const Token* token) {
+        SymbolId symbol = token->getSymbol();
+        if (symbol == NO_SYMBOL) return;
+
+        if (symbol >= m_names.size()) {
+            m_names.resize(symbol + 1);
+        }
+        // only written when it changes, a shared registry's names are read concurrently
+        if (!m_names[symbol].declared) {
+            m_names[symbol].declared = true;
+        }
+    }
+
+    // on while several parsers intern into this registry at once
+    void setShared(bool shared) {
+        m_shared = shared;
+    }
+
+    bool isDeclared(const Token* token) {
+        Name* name = find(token);
+        return name && name->declared;
+    }
+
+    // `typealias target name`, `target` comes from parseType() and is already resolved
+    void alias(const Token* name, NodeType* target) {
+        declare(name);
+        if (Name* entry = find(name)) {
+            entry->alias = target;
+        }
+    }
+
+    // the type a type keyword or declared name stands for
+    NodeType* named(Arena& arena, Token* token) {
+        if (Name* name = find(token); name && name->alias) {
+            return name->alias;
+        }
+
+        Key key{.form = Form::_name, .first = static_cast<uint64_t>(token->getTokenType()), .second = token->getSymbol(), .elements = {}};
+        return intern(std::move(key), [&] {
+            return arena.make<NodeType>(NodeType{._type = token});
+        });
+    }
+
+    // `element[size]`, `size` is nullptr for `element[*]`
+    NodeType* array(Arena& arena, NodeType* element, NodeInteger* size) {
+        Key key{.form = Form::_array, .first = address(element), .second = size ? static_cast<uint64_t>(size->_value) : UINT64_MAX, .elements = {}};
+        return intern(std::move(key), [&] {
+            NodeTypeArray* node_type_array = arena.make<NodeTypeArray>(NodeTypeArray{._type = element, ._index = size});
+            return arena.make<NodeType>(NodeType{._type = node_type_array});
+        });
+    }
+
+    NodeType* vector(Arena& arena, NodeType* element) {
+        return intern(Key{.form = Form::_vector, .first = address(element), .elements = {}}, [&] {
+            NodeTypeVector* node_type_vector = arena.make<NodeTypeVector>(NodeTypeVector{._type = element});
+            return arena.make<NodeType>(NodeType{._type = node_type_vector});
+        });
+    }
+
+    NodeType* tuple(Arena& arena, NodeTypeTuple* node_type_tuple) {
+        Key key{.form = Form::_tuple, .elements = {}};
+        key.elements.assign(node_type_tuple->_types.begin(), node_type_tuple->_types.end());
+        return intern(std::move(key), [&] {
+            return arena.make<NodeType>(NodeType{._type = node_type_tuple});
+        });
+    }
+
+    // distinct types built so far
+    std::size_t size() const {
+        std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+        if (m_shared) lock.lock();
+        return m_interned.size();
+    }
+};
+
+/*
+    Operators, classified by one load from OPERATOR_TABLE.
+
+    Each entry holds the precedence the Pratt loop in parseExpression()
+    binds with, whether the operator is right associative and whether it
+    may appear as a binary, prefix or postfix operator. Token types that
+    are not operators keep the all-zero entry. `+` and `-` come in as
+    separate unary and binary token types, the tokenizer has already told
+    them apart.
+*/
+enum OperatorFlags : uint8_t {
+    OP_BINARY = 1,
+    OP_PREFIX = 2,
+    OP_POSTFIX = 4,
+};
+
+struct OperatorInfo {
+    uint8_t precedence = 0;
+    bool right_associative = false;
+    uint8_t flags = 0;
+};
+
+struct OperatorEntry {
+    TokenType type;
+    OperatorInfo info;
+};
+
+constexpr OperatorEntry OPERATORS[] = {
+    {TokenType::_period, {13, false, OP_POSTFIX}},
+    {TokenType::_open_square, {12, false, OP_POSTFIX}},
+    {TokenType::_dbl_period, {11, false, OP_BINARY}},
+    {TokenType::_unary_plus, {10, true, OP_PREFIX}},
+    {TokenType::_unary_minus, {10, true, OP_PREFIX}},
+    {TokenType::_not, {10, true, OP_PREFIX}},
+    {TokenType::_hat, {9, true, OP_BINARY}},
+    {TokenType::_asterisk, {8, false, OP_BINARY}},
+    {TokenType::_fwd_slash, {8, false, OP_BINARY}},
+    {TokenType::_mod, {8, false, OP_BINARY}},
+    {TokenType::_dbl_asterisk, {8, false, OP_BINARY}},
+    {TokenType::_binary_plus, {7, false, OP_BINARY}},
+    {TokenType::_binary_minus, {7, false, OP_BINARY}},
+    {TokenType::_by, {6, false, OP_BINARY}},
+    {TokenType::_less_than, {5, false, OP_BINARY}},
+    {TokenType::_greater_than, {5, false, OP_BINARY}},
+    {TokenType::_less_than_equal, {5, false, OP_BINARY}},
+    {TokenType::_greater_than_equal, {5, false, OP_BINARY}},
+    {TokenType::_check_equal, {4, false, OP_BINARY}},
+    {TokenType::_not_eq, {4, false, OP_BINARY}},
+    {TokenType::_and, {3, false, OP_BINARY}},
+    {TokenType::_or, {2, false, OP_BINARY}},
+    {TokenType::_xor, {2, false, OP_BINARY}},
+    {TokenType::_dbl_vertical_line, {1, true, OP_BINARY}},
+    {TokenType::_in, {0, false, OP_BINARY}},
+    {TokenType::_vert_line, {0, false, OP_BINARY}},
+};
+
+constexpr std::size_t OPERATOR_TABLE_SIZE = static_cast<std::size_t>(TokenType::_eof) + 1;
+
+constexpr std::array<OperatorInfo, OPERATOR_TABLE_SIZE> buildOperatorTable() {
+    std::array<OperatorInfo, OPERATOR_TABLE_SIZE> table{};
+    for (const OperatorEntry& entry : OPERATORS) {
+        table[static_cast<std::size_t>(entry.type)] = entry.info;
+    }
+    return table;
+}
+
+constexpr std::array<OperatorInfo, OPERATOR_TABLE_SIZE> OPERATOR_TABLE = buildOperatorTable();
+
+constexpr const OperatorInfo& operatorInfo(TokenType type) {
+    return OPERATOR_TABLE[static_cast<std::size_t>(type)];
+}
+
+static_assert(operatorInfo(TokenType::_asterisk).precedence > operatorInfo(TokenType::_binary_plus).precedence);
+static_assert(operatorInfo(TokenType::_hat).right_associative && !operatorInfo(TokenType::_binary_minus).right_associative);
+static_assert(operatorInfo(TokenType::_in).flags == OP_BINARY && operatorInfo(TokenType::_semi).flags == 0);
+
+/*
+    Parser::parseExpression() and Parser::parseStatement() keep the constructs
+    they are inside of on these heap-backed stacks instead of the call stack,
+    so how deep a program nests is only limited by memory.
+
+    An ExpressionFrame is one level of the Pratt parser: its minimum
+    precedence and, while a nested operand is being parsed, what to do with
+    it once it is done (close a parenthesis, apply a prefix operator, become
+    the rhs of `op`, the next item of the tuple or list in `lhs`, or the
+    index or next call argument of `identifier`).
+*/
+enum class ExpressionPending : uint8_t {
+    _none,
+    _paren,
+    _prefix,
+    _rhs,
+    // items after `identifier,` and after `(expression,`
+    _tuple,
+    _paren_tuple,
+    _list,
+    _index,
+    _call,
+};
+
+struct ExpressionFrame {
+    int min_precedence;
+    int is_tuple_assignment;
+    ExpressionPending pending = ExpressionPending::_none;
+    NodeExpression* lhs = nullptr;
+    Token* op = nullptr;
+    // the identifier operand whose `[` or `(` suffix is being parsed
+    NodeIdentifier* identifier = nullptr;
+};
+
+/*
+    A StatementFrame is a block, if or loop statement whose body is being
+    parsed. `_else` is an if statement waiting on its else branch.
+*/
+enum class StatementPending : uint8_t {
+    _block,
+    _if,
+    _else,
+    _loop,
+};
+
+struct StatementFrame {
+    StatementPending pending;
+    NodeStatement* statement;
+    // condition of the if / else if branch whose body is being parsed
+    NodeExpression* condition = nullptr;
+};
+
+/*
+    An AccessFrame is one name of a member access chain `a.b.c` that
+    Parser::parseIdentifier() is in, waiting on the rest of the chain while
+    `access` is set.
+*/
+struct AccessFrame {
+    NodeIdentifierToken* token;
+    NodeIdentifier* identifier;
+    int main;
+    // `token.` and what it accesses, once that is parsed
+    NodeIdentifier* access = nullptr;
+};
+
 class Parser {
 private:
+    // owns every node of the AST, the tree lives as long as the Parser
+    Arena m_arena;
     NodeProgram* m_program;
-    std::vector<Token> m_tokens;
-    std::vector<std::string> m_types;
-    std::unordered_map<std::string, NodeType*> m_typealias_map;
-    std::vector<Token>::iterator m_tokens_pointer;
+    TokenStream m_tokens;
+    TypeRegistry m_own_types;
+    // m_own_types, or the registry of the parser a chunk parser was made by
+    TypeRegistry* m_types = &m_own_types;
+    std::size_t m_pos = 0;
+    // explicit parse stacks, kept between calls so their storage is reused
+    std::vector<ExpressionFrame> m_expression_frames;
+    std::vector<StatementFrame> m_statement_frames;
+    std::vector<AccessFrame> m_access_frames;
+    // vector and tuple types parseType() is inside of, types still parse recursively
+    int m_type_depth = 0;
+    // arenas of the chunk parsers parseParallel() ran, they own part of the AST
+    std::vector<Arena> m_chunk_arenas;
+    // chunks whose elements parseParallel() used, 0 after a serial parse
+    std::size_t m_parallel_chunks = 0;
+    // top-level functions whose bodies were skipped, by the token their element starts at
+    bool m_lazy_bodies = false;
+    std::vector<std::pair<std::size_t, NodeFunctionDecleration*>> m_lazy_functions;
+
+    // a parser for one chunk of parseParallel(), `tokens` is a view of the parent's and `types` is its registry
+    Parser(TokenStream&& tokens, TypeRegistry* types, bool lazy_bodies)
+        : m_tokens(std::move(tokens)), m_types(types), m_lazy_bodies(lazy_bodies) {
+        m_program = m_arena.make<NodeProgram>();
+    }
+
     public:
+        // parseParallel() parses serially below this many tokens
+        static constexpr std::size_t PARALLEL_MIN_TOKENS = 1 << 16;
+        // deeper vector and tuple types are an error instead of a stack overflow
+        static constexpr int MAX_TYPE_DEPTH = 1000;
+
         Parser() {
-            m_program = new NodeProgram();
+            m_program = m_arena.make<NodeProgram>();
+        }
+
+        // takes over `tokens`, pass them with std::move, the AST points into them
+        Parser(std::vector<Token>&& tokens) : m_tokens(std::move(tokens)) {
+            m_program = m_arena.make<NodeProgram>();
         }
 
-        Parser(std::vector<Token>& tokens) {
-            m_program = new NodeProgram();
-            m_tokens = tokens;
-            m_tokens_pointer = m_tokens.begin();
+        // pulls tokens from `tokenizer` as parsing reaches them
+        Parser(Tokenizer& tokenizer) : m_tokens(tokenizer) {
+            m_program = m_arena.make<NodeProgram>();
         }
 
     void printStruct(NodeStruct* _struct, int indent) {
-        printDebug("printing struct");
+        LOG_DEBUG("printing struct");
 
         std::string output_prefix = getDebugPrefix(indent);
 
         printIdentifier(_struct->_type, indent);
 
-        printDebug("printing arguments");
+        LOG_DEBUG("printing arguments");
         printFunctionDeclerationArguments(_struct->_arguments, indent, false);
     }
 
     void printTuple(NodeTuple* node_tuple, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
-        printDebug(output_prefix + "[tuple] (");
+        LOG_DEBUG(output_prefix + "[tuple] (");
         for (auto expression : node_tuple->_expressions) {
             printExpression(expression, indent + 1);
         }
-        printDebug(output_prefix + "),");
+        LOG_DEBUG(output_prefix + "),");
     }
 
     void printExpression(NodeExpression* expression, int indent) {
@@ -261,10 +602,10 @@ private:
 
             NodeExpressionBinary* node_binary = std::get<NodeExpressionBinary*>(expression->_expression);
             if (node_binary->_operator) {
-                printDebug(output_prefix + node_binary->_operator->_token->getStrValue() + " (");
+                LOG_DEBUG(output_prefix + std::string(node_binary->_operator->_token->getStrValue()) + " (");
                 printExpression(node_binary->_lhs, indent + 1);
                 printExpression(node_binary->_rhs, indent + 1);
-                printDebug(output_prefix + ")");
+                LOG_DEBUG(output_prefix + ")");
             }
 
         } else if (std::holds_alternative<NodeTuple*>(expression->_expression)) {
@@ -273,15 +614,15 @@ private:
 
         } else if (std::holds_alternative<NodeInteger*>(expression->_expression)) {
             NodeInteger* node_integer = std::get<NodeInteger*>(expression->_expression);
-            printDebug(output_prefix + std::to_string(node_integer->_value));
+            LOG_DEBUG(output_prefix + std::to_string(node_integer->_value));
 
         } else if (std::holds_alternative<NodeCharacter*>(expression->_expression)) {
             NodeCharacter* node_character = std::get<NodeCharacter*>(expression->_expression);
-            printDebug(output_prefix + node_character->_value);
+            LOG_DEBUG(output_prefix + std::string(LiteralTable::global().text(node_character->_literal)));
 
         } else if (std::holds_alternative<NodeString*>(expression->_expression)) {
             NodeString* node_string = std::get<NodeString*>(expression->_expression);
-            printDebug(output_prefix + node_string->_value);
+            LOG_DEBUG(output_prefix + std::string(LiteralTable::global().text(node_string->_literal)));
 
         } else if (std::holds_alternative<NodeIdentifier*>(expression->_expression)) {
             NodeIdentifier* node_identifier = std::get<NodeIdentifier*>(expression->_expression);
@@ -289,28 +630,28 @@ private:
 
         } else if (std::holds_alternative<NodeBoolean*>(expression->_expression)) {
             NodeBoolean* node_boolean = std::get<NodeBoolean*>(expression->_expression);
-            printDebug(output_prefix + node_boolean->_token->getStrValue());
+            LOG_DEBUG(output_prefix + std::string(node_boolean->_token->getStrValue()));
 
         } else if (std::holds_alternative<NodeGenerator*>(expression->_expression)) {
             NodeGenerator* node_generator = std::get<NodeGenerator*>(expression->_expression);
-            printDebug(output_prefix + node_generator->_token->getStrValue());
+            LOG_DEBUG(output_prefix + std::string(node_generator->_token->getStrValue()));
 
         } else if (std::holds_alternative<NodeFunctionCall*>(expression->_expression)) {
             NodeFunctionCall* node_function_call = std::get<NodeFunctionCall*>(expression->_expression);
-            printDebug(output_prefix + "[function call]");
+            LOG_DEBUG(output_prefix + "[function call]");
             printIdentifier(node_function_call->_identifier, indent + 1);
-            printDebug(output_prefix + "(");
+            LOG_DEBUG(output_prefix + "(");
 
             for (std::vector<NodeFunctionCallArgument*>::iterator i = node_function_call->_arguments.begin(); i < node_function_call->_arguments.end(); i++) {
                 printExpression((*i)->_expression, indent + 1);
             }
-            printDebug(output_prefix + ")");
+            LOG_DEBUG(output_prefix + ")");
 
         } else if (std::holds_alternative<NodeExpressionUnary*>(expression->_expression)) {
             NodeExpressionUnary* node_expression_unary = std::get<NodeExpressionUnary*>(expression->_expression);
-            printDebug(output_prefix + node_expression_unary->_operator->_token->getStrValue() + " (");
+            LOG_DEBUG(output_prefix + std::string(node_expression_unary->_operator->_token->getStrValue()) + " (");
             printExpression(node_expression_unary->_expression, indent + 1);
-            printDebug(output_prefix + ")");
+            LOG_DEBUG(output_prefix + ")");
 
         } else if (std::holds_alternative<NodeList*>(expression->_expression)) {
             NodeList* node_list = std::get<NodeList*>(expression->_expression);
@@ -318,7 +659,7 @@ private:
 
         } else if (std::holds_alternative<NodeRange*>(expression->_expression)) {
             NodeRange* range = std::get<NodeRange*>(expression->_expression);
-            printDebug(output_prefix + "[range]");
+            LOG_DEBUG(output_prefix + "[range]");
             printExpression(range->_start, indent + 1);
             printExpression(range->_end, indent + 1);
 
@@ -327,10 +668,10 @@ private:
 
             NodeAssign* node_assign = std::get<NodeAssign*>(expression->_expression);
             if (node_assign->_operator) {
-                printDebug(output_prefix + node_assign->_operator->_token->getStrValue() + " (");
+                LOG_DEBUG(output_prefix + std::string(node_assign->_operator->_token->getStrValue()) + " (");
                 printExpression(node_assign->_lhs, indent + 1);
                 printExpression(node_assign->_rhs, indent + 1);
-                printDebug(output_prefix + ")");
+                LOG_DEBUG(output_prefix + ")");
             }
 
         } else {
@@ -341,11 +682,11 @@ private:
     void printList(NodeList* node_list, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(output_prefix + "[");
+        LOG_DEBUG(output_prefix + "[");
         for (auto element : node_list->_items) {
             printExpression(element, indent + 1);
         }
-        printDebug(output_prefix + "]");
+        LOG_DEBUG(output_prefix + "]");
     }
 
     void printDecleration(NodeDecleration* decleration, int indent) {
@@ -353,16 +694,16 @@ private:
         
         // print qualifier
         if (decleration->_qualifier) {
-            printDebug(output_prefix + decleration->_qualifier->_token->getStrValue());
+            LOG_DEBUG(output_prefix + std::string(decleration->_qualifier->_token->getStrValue()));
         } else {
-            printDebug(output_prefix + "[No qualifier]");
+            LOG_DEBUG(output_prefix + "[No qualifier]");
         }
 
         // print type
         if (std::holds_alternative<Token*>(decleration->_type))  {
             Token* token = std::get<Token*>(decleration->_type);
             if (token != nullptr) {
-                printDebug(output_prefix + token->getStrValue());
+                LOG_DEBUG(output_prefix + std::string(token->getStrValue()));
             }
 
         } else if (std::holds_alternative<NodeTypeTuple*>(decleration->_type))  {
@@ -378,22 +719,22 @@ private:
             }
 
         } else {
-            printDebug(output_prefix + "[No type]");
+            LOG_DEBUG(output_prefix + "[No type]");
         }
 
         if (std::holds_alternative<NodeStruct*>(decleration->_type) && std::get<NodeStruct*>(decleration->_type)) {
-            printDebug("Passes struct");
+            LOG_DEBUG("Passes struct");
             
             NodeStruct* node_struct = std::get<NodeStruct*>(decleration->_type);
             if (node_struct != nullptr) {
-                printDebug(output_prefix + "[struct Type]");
+                LOG_DEBUG(output_prefix + "[struct Type]");
                 printStruct(node_struct, indent);
             }
         }
 
         // print identifier
         else if (decleration->_identifier) {
-            printDebug("Passes identifier");
+            LOG_DEBUG("Passes identifier");
 
             NodeIdentifier* node_identifier = decleration->_identifier;
             printIdentifier(node_identifier, indent);
@@ -403,10 +744,10 @@ private:
         }
 
         if (decleration->_expression != NULL) {
-            printDebug(output_prefix + "[Expression]");
+            LOG_DEBUG(output_prefix + "[Expression]");
             printExpression(decleration->_expression, indent + 1);
         } else {
-            printDebug(output_prefix + "[No expression]");
+            LOG_DEBUG(output_prefix + "[No expression]");
         }
     }
 
@@ -420,7 +761,7 @@ private:
 
         if (std::holds_alternative<Token*>(node_type->_type)) {
             Token* token = std::get<Token*>(node_type->_type);
-            printDebug(output_prefix + token->getStrValue());
+            LOG_DEBUG(output_prefix + std::string(token->getStrValue()));
 
         } else if (std::holds_alternative<NodeTypeTuple*>(node_type->_type)) {
             NodeTypeTuple* node_type_tuple = std::get<NodeTypeTuple*>(node_type->_type);
@@ -428,7 +769,7 @@ private:
 
         } else if (std::holds_alternative<NodeTypeVector*>(node_type->_type)) {
             NodeTypeVector* node_type_vector = std::get<NodeTypeVector*>(node_type->_type);
-            printDebug(output_prefix + "[vector identifier]");
+            LOG_DEBUG(output_prefix + "[vector identifier]");
             printVectorType(node_type_vector, indent + 1);
 
         } else if (std::holds_alternative<NodeTypeArray*>(node_type->_type)) {
@@ -443,7 +784,7 @@ private:
     void printInteger(NodeInteger* node_integer, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(output_prefix + std::to_string(node_integer->_value));
+        LOG_DEBUG(output_prefix + std::to_string(node_integer->_value));
     }
 
     std::string getDebugPrefix(int indent) {
@@ -461,18 +802,18 @@ private:
 
         printType(node_type_array->_type, indent);
         if (node_type_array->_index) {
-            printDebug(output_prefix + "[");
+            LOG_DEBUG(output_prefix + "[");
             printInteger(node_type_array->_index, indent + 1);
-            printDebug(output_prefix + "]");
+            LOG_DEBUG(output_prefix + "]");
         } else {
-            printDebug(output_prefix + "[*]");
+            LOG_DEBUG(output_prefix + "[*]");
         }
     }
 
     void printTupleType(NodeTypeTuple* node_type_tuple, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(output_prefix + "[tuple type]");
+        LOG_DEBUG(output_prefix + "[tuple type]");
 
         for (NodeType* type : node_type_tuple->_types) {
             printType(type, indent + 1);
@@ -487,22 +828,22 @@ private:
 
     void printIdentifier(NodeIdentifier* identifier, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
-        printDebug("printing identifier");
+        LOG_DEBUG("printing identifier");
 
         if (identifier->_access_token) {
-            printDebug(output_prefix + ". (");
+            LOG_DEBUG(output_prefix + ". (");
             printIdentifier(identifier->_access_token, indent + 1);
-            printDebug(output_prefix + ")");
+            LOG_DEBUG(output_prefix + ")");
         }
 
         if (std::holds_alternative<NodeIdentifierToken*>(identifier->_identifier)) {
-            printDebug("printing NodeIdentifierToken");
+            LOG_DEBUG("printing NodeIdentifierToken");
             NodeIdentifierToken* node_identifier_token = std::get<NodeIdentifierToken*>(identifier->_identifier);
             printIdentifierToken(node_identifier_token, indent);
         }
 
         else if (std::holds_alternative<NodeTupleIdentifier*>(identifier->_identifier)) {
-            printDebug("printing NodeTupleIdentifier");
+            LOG_DEBUG("printing NodeTupleIdentifier");
 
             NodeTupleIdentifier* node_identifier_tuple = std::get<NodeTupleIdentifier*>(identifier->_identifier);
             for (auto identifier : node_identifier_tuple->_identifiers) {
@@ -512,24 +853,24 @@ private:
         }
         
         else if (std::holds_alternative<NodeArrayIndex*>(identifier->_identifier)) {
-            printDebug("found NodeArrayIndex");
+            LOG_DEBUG("found NodeArrayIndex");
             NodeArrayIndex* node_array_index = std::get<NodeArrayIndex*>(identifier->_identifier);
             printIdentifier(node_array_index->_identifier, indent);
 
-            printDebug(output_prefix + "[");
+            LOG_DEBUG(output_prefix + "[");
             printExpression(node_array_index->_expression, indent + 1);
-            printDebug(output_prefix + "]");
+            LOG_DEBUG(output_prefix + "]");
 
         }
         
         else if (std::holds_alternative<NodeFunctionCall*>(identifier->_identifier)) {
-            printDebug("found NodeFunctionCall");
+            LOG_DEBUG("found NodeFunctionCall");
             NodeFunctionCall* node_function_call = std::get<NodeFunctionCall*>(identifier->_identifier);
             printIdentifier(node_function_call->_identifier, indent + 1);
     
-            printDebug(output_prefix + "(");        
+            LOG_DEBUG(output_prefix + "(");        
             printCallArguments(node_function_call, indent + 1);
-            printDebug(output_prefix + ")");
+            LOG_DEBUG(output_prefix + ")");
 
             
         }
@@ -544,20 +885,20 @@ private:
     void printFunctionDecleration(NodeFunctionDecleration* function_decleration, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(output_prefix + "[arguments]");
-        printFunctionDeclerationArguments(function_decleration->_arguments, indent, *(function_decleration->is_procedure));
+        LOG_DEBUG(output_prefix + "[arguments]");
+        printFunctionDeclerationArguments(function_decleration->_arguments, indent, function_decleration->is_procedure);
 
-        if (*(function_decleration->is_procedure) == false) {
-            printDebug(output_prefix + "[function Decleration]");
+        if (function_decleration->is_procedure == false) {
+            LOG_DEBUG(output_prefix + "[function Decleration]");
             printIdentifier(function_decleration->_identifier, indent);
 
             output_prefix += "    ";
-            printDebug(output_prefix + "[returns]");
+            LOG_DEBUG(output_prefix + "[returns]");
             printType(function_decleration->_return_type, indent + 1);
 
 
-        } else if (*(function_decleration->is_procedure) == true) {
-            printDebug(output_prefix + "[procedure Decleration]");
+        } else if (function_decleration->is_procedure == true) {
+            LOG_DEBUG(output_prefix + "[procedure Decleration]");
             printIdentifier(function_decleration->_identifier, indent + 1);
 
         } else {
@@ -574,7 +915,7 @@ private:
     void printFunctionDeclerationArguments(std::vector<NodeFunctionDeclerationArgument*> arguments, int indent, bool is_procedure) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(std::to_string(arguments.size()));
+        LOG_DEBUG(std::to_string(arguments.size()));
         for (auto argument : arguments) {
             if (is_procedure == true) {
                 printQualifier(argument->_qualifier, indent + 1);
@@ -588,7 +929,7 @@ private:
 
     void printQualifier(NodeQualifier* node_qualifier, int indent) {
         std::string output_prefix = getDebugPrefix(indent);
-        printDebug(output_prefix + node_qualifier->_token->getStrValue());
+        LOG_DEBUG(output_prefix + std::string(node_qualifier->_token->getStrValue()));
     }
 
     void printElement(NodeProgramElement* program_element, int indent) {
@@ -618,12 +959,12 @@ private:
         std::string output_prefix = getDebugPrefix(indent);
 
         if (std::holds_alternative<NodeDecleration*>(statement->_statement)) {
-            printDebug(output_prefix + "[Decleration]");
+            LOG_DEBUG(output_prefix + "[Decleration]");
             printDecleration(std::get<NodeDecleration*>(statement->_statement), indent + 1);
 
         } else if (std::holds_alternative<NodeBlock*>(statement->_statement)) {
             output_prefix += "[block]";
-            printDebug(output_prefix);
+            LOG_DEBUG(output_prefix);
             NodeBlock* node_block = std::get<NodeBlock*>(statement->_statement);
             for (auto element : node_block->_elements) {
                 printElement(element, indent + 1);
@@ -631,12 +972,12 @@ private:
 
         } else if (std::holds_alternative<NodeControl*>(statement->_statement)) {
             NodeControl* node_control = std::get<NodeControl*>(statement->_statement);
-            printDebug(output_prefix + "[if]");
+            LOG_DEBUG(output_prefix + "[if]");
             printExpression(node_control->_if.first, indent);
             printStatement(node_control->_if.second, indent + 1);
 
             for (auto else_if : node_control->_else_if) {
-                printDebug(output_prefix + "[elif]");
+                LOG_DEBUG(output_prefix + "[elif]");
                 printExpression(else_if.first, indent);
                 printStatement(else_if.second, indent + 1);
             }
@@ -649,32 +990,32 @@ private:
             NodeStatementToken* node_statement_token = std::get<NodeStatementToken*>(statement->_statement);
 
             if (node_statement_token->_token->getTokenType() == TokenType::_continue) {
-                printDebug(output_prefix + "[continue]");
+                LOG_DEBUG(output_prefix + "[continue]");
 
             } else if (node_statement_token->_token->getTokenType() == TokenType::_break) {
-                printDebug(output_prefix + "[break]");
+                LOG_DEBUG(output_prefix + "[break]");
             }
 
         } else if (std::holds_alternative<NodeStream*>(statement->_statement)) {
             NodeStream* node_stream = std::get<NodeStream*>(statement->_statement);
-            printDebug(output_prefix + "[stream]");
+            LOG_DEBUG(output_prefix + "[stream]");
             output_prefix += "    ";
-            printDebug(output_prefix + node_stream->_operator->getStrValue() + " " + node_stream->_destination->getStrValue() + " (");
+            LOG_DEBUG(output_prefix + std::string(node_stream->_operator->getStrValue()) + " " + std::string(node_stream->_destination->getStrValue()) + " (");
             printExpression(node_stream->_expression, indent + 2);
-            printDebug(output_prefix + ")");
+            LOG_DEBUG(output_prefix + ")");
         
         } else if (std::holds_alternative<NodeLoop*>(statement->_statement)) {
             NodeLoop* node_loop = std::get<NodeLoop*>(statement->_statement);
-            printDebug(output_prefix + "[loop]");
+            LOG_DEBUG(output_prefix + "[loop]");
             if (node_loop->_expression) {
-                if (*node_loop->_predicated) {
-                    printDebug(output_prefix + "[predicated while]");
+                if (node_loop->_predicated) {
+                    LOG_DEBUG(output_prefix + "[predicated while]");
                     printExpression(node_loop->_expression, indent + 1);
                     printStatement(node_loop->_statement, indent + 1);
 
                 } else {
                     printStatement(node_loop->_statement, indent + 1);
-                    printDebug(output_prefix + "[post-predicated while]");
+                    LOG_DEBUG(output_prefix + "[post-predicated while]");
                     printExpression(node_loop->_expression, indent + 1);
                 }
             } else {
@@ -683,50 +1024,51 @@ private:
 
         } else if (std::holds_alternative<NodeReturn*>(statement->_statement)) {
             NodeReturn* node_return = std::get<NodeReturn*>(statement->_statement);
-            printDebug(output_prefix + "[return]");
+            LOG_DEBUG(output_prefix + "[return]");
             if (node_return->_expression) {
                 printExpression(node_return->_expression, indent + 1);
             }
 
         } else if (std::holds_alternative<NodeCall*>(statement->_statement)) {
             NodeCall* node_call = std::get<NodeCall*>(statement->_statement);
-            printDebug(output_prefix + "[call]");
+            LOG_DEBUG(output_prefix + "[call]");
             printIdentifier(node_call->_function_call->_identifier, indent + 1);
 
         } else if (std::holds_alternative<NodeAssign*>(statement->_statement)) {
             NodeAssign* node_assign = std::get<NodeAssign*>(statement->_statement);
-            printExpression(new NodeExpression{._expression = node_assign}, indent);
+            NodeExpression wrapper{._expression = node_assign};
+            printExpression(&wrapper, indent);
 
         } else {
-            printDebug("1");
+            LOG_DEBUG("1");
             printError("Unexpected statement encountered during print" + std::string(typeid(statement->_statement).name()));
         }
     }
 
     void printToken(Token* token, int indent = 0) {
         std::string output_prefix = getDebugPrefix(indent);
-        printDebug(output_prefix + token->getStrValue());
+        LOG_DEBUG(output_prefix + std::string(token->getStrValue()));
     }
 
     void printTypealias(NodeTypealias* node_typealias, int indent = 0) {
         std::string output_prefix = getDebugPrefix(indent);
 
-        printDebug(output_prefix + "[typealias]");
-        printDebug(output_prefix + "[original]");
+        LOG_DEBUG(output_prefix + "[typealias]");
+        LOG_DEBUG(output_prefix + "[original]");
         printType(node_typealias->_original, indent + 1);
-        printDebug(output_prefix + "[new] " + node_typealias->_new->getStrValue());
+        LOG_DEBUG(output_prefix + "[new] " + std::string(node_typealias->_new->getStrValue()));
     }
 
     void printProgram(NodeProgram* program){
         int indent = 0;
 
-        printDebug(std::string("printing program ") + std::to_string((program->_elements).size()));
+        LOG_DEBUG(std::string("printing program ") + std::to_string((program->_elements).size()));
 
         for (std::vector<NodeProgramElement*>::iterator i = program->_elements.begin(); i < program->_elements.end(); i++) {
             printElement(*i, indent);
         }
 
-        printOk("Program printed");
+        LOG_OK("Program printed");
     }
 
     void printError(std::string error_msg) {
@@ -737,18 +1079,11 @@ private:
         throw std::runtime_error(std::string(RED) + error_msg + " at " + std::to_string(line) + ":" + std::to_string(_char) + "\033[0m");
     }
 
-    void printDebug(std::string msg) {
-        std::cout << std::string(CYAN) + "[debug] " + msg + "\033[0m" << std::endl;
-    }
-
-    void printOk(std::string msg) {
-        std::cout << std::string(GREEN) + "[ok] " + msg + "\033[0m" << std::endl;
-    }
 
 
     bool isQualifier(Token* token) {
         TokenType token_type = token->getTokenType();
-        printDebug(token->getStrValue());
+        LOG_TRACE(std::string(token->getStrValue()));
 
         return token_type == TokenType::_const || token_type == TokenType::_var;
     }
@@ -763,18 +1098,13 @@ private:
     }
 
     bool isInteger(Token* token) {
-        printDebug("isInteger: `" + token->getStrValue() + "`");
-
-        for (char s : token->getStrValue()) {
-            printDebug("isInteger: " + std::string(1, s));
-            if (!std::isdigit(s)) return false;
-        }
-        return true;
+        LOG_TRACE("isInteger: `" + std::string(token->getStrValue()) + "`");
+        return token->getTokenType() == TokenType::_int_lit;
     }
 
     bool isType(Token* token) {
         TokenType token_type = token->getTokenType();
-        printDebug(token->getStrValue());
+        LOG_TRACE(std::string(token->getStrValue()));
 
         switch (token_type)
         {
@@ -786,327 +1116,408 @@ private:
             case TokenType::_struct:
             case TokenType::_vector:
             case TokenType::_string:
-                printDebug("found type token");
+                LOG_TRACE("found type token");
                 return true;
             default:
-                printDebug("not a type token");
+                LOG_TRACE("not a type token");
                 break;
         }
 
-        if (std::find(m_types.begin(), m_types.end(), token->getStrValue()) != m_types.end()) {
-            return true;
-        }
-
-        return false;
+        return m_types->isDeclared(token);
     }
 
-    bool isOperator(Token* token) {
-        printDebug(token->getStrValue());
-        switch (token->getTokenType())
-        {
-            case TokenType::_period:
-            case TokenType::_open_square:
-            case TokenType::_dbl_period:
-            case TokenType::_unary_plus:
-            case TokenType::_binary_plus:
-            case TokenType::_unary_minus:
-            case TokenType::_binary_minus:
-            case TokenType::_not:
-            case TokenType::_hat:
-            case TokenType::_asterisk:
-            case TokenType::_fwd_slash:
-            case TokenType::_mod:
-            case TokenType::_dbl_asterisk:
-            case TokenType::_by:
-            case TokenType::_greater_than:
-            case TokenType::_less_than:
-            case TokenType::_greater_than_equal:
-            case TokenType::_less_than_equal:
-            case TokenType::_check_equal:
-            case TokenType::_not_eq:
-            case TokenType::_and:
-            case TokenType::_or:
-            case TokenType::_xor:
-            case TokenType::_dbl_vertical_line:
-            case TokenType::_in:
-            case TokenType::_vert_line:
-                return true;
-            default:
-                return false;
+    /*
+        returns true if the statement at the current token is a declaration.
+        Decided from at most two tokens, so a statement is parsed once without
+        trying one rule and rewinding to the next.
+    */
+    bool isDecleration() {
+        if (isQualifier(peekToken()) || _isTokenType(TokenType::_struct)) {
+            return true;
         }
-    }
 
-    int isRightAssociative(Token* token) {
-        TokenType token_type = token->getTokenType();
-
-        if (token_type == TokenType::_unary_plus || token_type == TokenType::_unary_minus || token_type == TokenType::_not || token_type == TokenType::_hat || token_type == TokenType::_dbl_vertical_line) {
-            return 1;
+        if (_isTokenType(TokenType::_identifier)) {
+            // `T x` and, for a struct or typealias name T, `T[3] x`
+            return _isTokenType(TokenType::_identifier, 1) || (isType(peekToken()) && _isTokenType(TokenType::_open_square, 1));
         }
-        return 0;
-    }
 
-    int getOperatorPrec(Token* token) {
-        TokenType token_type = token->getTokenType();
-        printDebug("getting operator precedence");
-        printDebug(token->getStrValue());
-
-        if (token_type == TokenType::_period) {
-            return 13;
-        } else if (token_type == TokenType::_open_square) {
-            return 12;
-        } else if (token_type == TokenType::_dbl_period) {
-            printDebug("DBL PERIOd");
-            return 11;
-        } else if (token_type == TokenType::_unary_plus || token_type == TokenType::_unary_minus || token_type == TokenType::_not) {
-            return 10;
-        } else if (token_type == TokenType::_hat) {
-            return 9;
-        } else if (token_type == TokenType::_asterisk || token_type == TokenType::_fwd_slash || token_type == TokenType::_mod || token_type == TokenType::_dbl_asterisk) {
-            return 8;
-        } else if (token_type == TokenType::_binary_plus || token_type == TokenType::_binary_minus) {
-            return 7;
-        } else if (token_type == TokenType::_by) {
-            return 6;
-        } else if (token_type == TokenType::_less_than || token_type == TokenType::_greater_than || token_type == TokenType::_less_than_equal || token_type == TokenType::_greater_than_equal) {
-            return 5;
-        } else if (token_type == TokenType::_check_equal || token_type == TokenType::_not_eq) {
-            return 4;
-        } else if (token_type == TokenType::_and) {
-            return 3;
-        } else if (token_type == TokenType::_or || token_type == TokenType::_xor) {
-            return 2;
-        } else if (token_type == TokenType::_dbl_vertical_line) {
-            return 1;
-        } else {
-            return 0;
-        }
+        return isType(peekToken());
     }
 
     NodeInteger* parseInteger(int raise_error = 0) {
-        NodeInteger* node_integer = new NodeInteger();
-        if (isInteger(&*m_tokens_pointer)) {
-            node_integer->_token = &*m_tokens_pointer;
-            node_integer->_value = std::stoi(m_tokens_pointer->getStrValue());
-            m_tokens_pointer++;
+        NodeInteger* node_integer = m_arena.make<NodeInteger>();
+        if (isInteger(peekToken())) {
+            node_integer->_token = peekToken();
+            node_integer->_value = peekToken()->getIntValue();
+            m_pos++;
 
         } else if (raise_error) {
-            printError("Expected integer", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+            printError("Expected integer", peekToken()->getLine(), peekToken()->getChar());
         }
 
         return node_integer;
     }
 
-    NodeExpression* parseTuple(NodeExpression* first_expression, int is_tuple_assignment) {
-        NodeExpression* node_expression = new NodeExpression();
-        NodeTuple* node_tuple = new NodeTuple();
-        node_tuple->_expressions.push_back(first_expression);
-
-        NodeExpression* temp_expression = new NodeExpression();
-        while (temp_expression = parseExpression(0, is_tuple_assignment)) {
-            node_tuple->_expressions.push_back(temp_expression);
+    /*
+        parses an expression with operators binding at least `min_precedence`,
+        nullptr if the next token cannot start one. Parentheses, prefix and rhs
+        operands, tuple and list items, indices and call arguments push an
+        ExpressionFrame rather than recursing.
+    */
+    NodeExpression* parseExpression(int min_precedence = 0, int is_tuple_assignment = 0) {
+        LOG_DEBUG("parsing expression with precedence: " + std::to_string(min_precedence));
+        std::size_t base = m_expression_frames.size();
+        m_expression_frames.push_back({min_precedence, is_tuple_assignment});
 
-            if (_isTokenType(TokenType::_comma)) {
-                m_tokens_pointer++;
+        while (true) {
+            std::size_t depth = m_expression_frames.size();
+            NodeExpression* lhs = parseOperand();
+            if (m_expression_frames.size() > depth) {
+                continue;
             }
-        }
 
-        node_expression->_expression = node_tuple;
-        return node_expression;
-    }
-
-    NodeExpression* parseExpression(int min_precedence = 0, int is_tuple_assignment = 0) {
-        printDebug("parsing expression with precedence: " + std::to_string(min_precedence));
-        printDebug("Token type: " + std::to_string(_isTokenType(TokenType::_number) ? 1 : 0));
-        printDebug("Token type: " + std::to_string(_isTokenType(TokenType::_unary_minus) ? 1 : 0));
-        printDebug("Token type: " + std::to_string(_isTokenType(TokenType::_binary_minus) ? 1 : 0));
-        NodeExpression* lhs = new NodeExpression();
-        
-        if (_isTokenType(TokenType::_open_paren) || _isTokenType(TokenType::_identifier)) {
-            if (_isTokenType(TokenType::_identifier)) {
-                printDebug("parsing expression identifier");
-                lhs = new NodeExpression();
-                lhs->_expression = parseIdentifier();
-                printDebug("Added identifier");
-
-                if (!is_tuple_assignment && _isTokenType(TokenType::_comma)) {
-                    if (is_tuple_assignment == 0) is_tuple_assignment = 1;
-                    m_tokens_pointer++;
-                    lhs = parseTuple(lhs, is_tuple_assignment);
+            // an operand that is not there ends its frame without looking for operators
+            bool found = lhs != nullptr;
+            while (true) {
+                if (found && parseOperator(lhs)) {
+                    break;
                 }
 
-            } else {
-                m_tokens_pointer++;
-                lhs = parseExpression(0);
-
-                if (is_tuple_assignment != -1 && _isTokenType(TokenType::_comma)) {
-                    m_tokens_pointer++;
-                    lhs = parseTuple(lhs, is_tuple_assignment);
+                m_expression_frames.pop_back();
+                if (m_expression_frames.size() == base) {
+                    LOG_DEBUG("returning expression");
+                    return lhs;
                 }
 
-                if (_isTokenType(TokenType::_close_paren)) {
-                    m_tokens_pointer++;
+                // the waiting frame may want another operand, a tuple item for one
+                std::size_t depth = m_expression_frames.size();
+                lhs = resumeExpression(lhs);
+                if (m_expression_frames.size() > depth) {
+                    break;
                 }
+                found = true;
             }
-        
-        } else if (_isTokenType(TokenType::_not) || _isTokenType(TokenType::_unary_plus) || _isTokenType(TokenType::_unary_minus)) {
-            printDebug("parsing unary operator");
-            
-            NodeExpressionUnary* node_expression_unary = new NodeExpressionUnary();
-            node_expression_unary->_operator = new NodeOperator{._token = &(*m_tokens_pointer)};
-            printOk("parsed unary operator");
-            m_tokens_pointer++;
+        }
+    }
 
-            node_expression_unary->_expression = parseExpression(10);
-            if (!node_expression_unary->_expression) {
-                printError("Expected expression", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
-            }
-            printOk("parsed unary expression");
-            lhs->_expression = node_expression_unary;
+    /*
+        parses the operand that starts the innermost expression frame. Returns
+        it, or nullptr either because there is none or because the operand
+        nests and a frame for its inside was pushed.
+    */
+    NodeExpression* parseOperand() {
+        ExpressionFrame& frame = m_expression_frames.back();
+        if (_isTokenType(TokenType::_open_paren)) {
+            m_pos++;
+            frame.pending = ExpressionPending::_paren;
+            m_expression_frames.push_back({0, 0});
+            return nullptr;
+        }
+
+        NodeExpression* lhs = nullptr;
+        if (_isTokenType(TokenType::_identifier)) {
+            LOG_DEBUG("parsing expression identifier");
+            // the name and its member accesses, parseIdentifierSuffix() does the rest
+            NodeIdentifier* identifier = parseIdentifier(false, 1);
+
+            // parseIdentifier() can grow the frame stack, `frame` may have moved
+            m_expression_frames.back().identifier = identifier;
+            return parseIdentifierSuffix();
+
+        } else if (operatorInfo(m_tokens.kind(m_pos)).flags & OP_PREFIX) {
+            LOG_DEBUG("parsing unary operator");
+            int precedence = operatorInfo(m_tokens.kind(m_pos)).precedence;
+            frame.pending = ExpressionPending::_prefix;
+            frame.lhs = m_arena.make<NodeExpression>();
+            frame.op = peekToken();
+            m_pos++;
+            m_expression_frames.push_back({precedence, 0});
+            return nullptr;
 
         } else if (_isTokenType(TokenType::_char_lit)) {
-            NodeCharacter* _character = new NodeCharacter{._token=&(*m_tokens_pointer), ._value=m_tokens_pointer->getStrValue()};
-            lhs->_expression = _character;
-            m_tokens_pointer++;
-            printDebug("Added character");
+            NodeCharacter* _character = m_arena.make<NodeCharacter>(NodeCharacter{._token=peekToken(), ._literal=peekToken()->getLiteral()});
+            lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = _character});
+            m_pos++;
+            LOG_DEBUG("Added character");
 
         } else if (_isTokenType(TokenType::_text)) {
-            NodeString* _string = new NodeString{._token=&(*m_tokens_pointer), ._value=m_tokens_pointer->getStrValue()};
-            lhs->_expression = _string;
-            m_tokens_pointer++;
-            printDebug("Added string");
+            NodeString* _string = m_arena.make<NodeString>(NodeString{._token=peekToken(), ._literal=peekToken()->getLiteral()});
+            lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = _string});
+            m_pos++;
+            LOG_DEBUG("Added string");
         
-        } else if (_isTokenType(TokenType::_number)) {
-            NodeInteger* _integer = new NodeInteger{._token=&(*m_tokens_pointer), ._value=std::stoi(m_tokens_pointer->getStrValue())};
-            lhs->_expression = _integer;
-            m_tokens_pointer++;
-            printDebug("Added integer");
+        } else if (_isTokenType(TokenType::_int_lit) || _isTokenType(TokenType::_number)) {
+            // reals are truncated until the generator has a floating point path
+            int64_t value = _isTokenType(TokenType::_int_lit) ? peekToken()->getIntValue() : static_cast<int64_t>(peekToken()->getRealValue());
+            NodeInteger* _integer = m_arena.make<NodeInteger>(NodeInteger{._token=peekToken(), ._value=value});
+            lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = _integer});
+            m_pos++;
+            LOG_DEBUG("Added integer");
 
         } else if (_isTokenType(TokenType::_true) || _isTokenType(TokenType::_false)) {
-            NodeBoolean* _boolean = new NodeBoolean{
-                ._token=&(*m_tokens_pointer), 
+            NodeBoolean* _boolean = m_arena.make<NodeBoolean>(NodeBoolean{
+                ._token=peekToken(), 
                 ._value=(_isTokenType(TokenType::_true))
-            };
+            });
 
-            lhs->_expression = _boolean;
-            m_tokens_pointer++;
-            printDebug("Added boolean");
+            lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = _boolean});
+            m_pos++;
+            LOG_DEBUG("Added boolean");
 
         } else if (_isTokenType(TokenType::_generator)) {
-            NodeGenerator* _generator = new NodeGenerator{._token = &(*m_tokens_pointer)};
-            lhs->_expression = _generator;
-            m_tokens_pointer++;
-            printDebug("Added generator");
+            NodeGenerator* _generator = m_arena.make<NodeGenerator>(NodeGenerator{._token = peekToken()});
+            lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = _generator});
+            m_pos++;
+            LOG_DEBUG("Added generator");
 
         } else if (_isTokenType(TokenType::_open_square)) {
-            m_tokens_pointer++;
-            NodeList* node_list = parseList();
-            lhs->_expression = node_list;
-            parseToken(TokenType::_close_square);
-
-            printDebug("Added generator");
+            m_pos++;
+            frame.pending = ExpressionPending::_list;
+            frame.lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = m_arena.make<NodeList>()});
+            m_expression_frames.push_back({0, 0});
+            return nullptr;
 
         } else {
-            printDebug("no expression");
+            LOG_DEBUG("no expression");
             return nullptr;
         }
 
-        printOk("parsed lhs");
+        LOG_OK("parsed lhs");
+        return lhs;
+    }
 
-        while (m_tokens_pointer < m_tokens.end() && isOperator(&(*m_tokens_pointer))) {
-            printDebug("found an operator");
+    /*
+        continues the identifier operand of the innermost frame: pushes a frame
+        for the index or first call argument of its next `[` or `(` suffix, or
+        returns it once it has none. An identifier followed by `,` starts a
+        tuple unless the frame is already inside one.
+    */
+    NodeExpression* parseIdentifierSuffix() {
+        ExpressionFrame& frame = m_expression_frames.back();
+        while (_isTokenType(TokenType::_open_square) || _isTokenType(TokenType::_open_paren)) {
+            if (_isTokenType(TokenType::_open_square)) {
+                LOG_DEBUG("found _open_square");
+                m_pos++;
+                NodeArrayIndex* node_array_index = m_arena.make<NodeArrayIndex>();
+                node_array_index->_identifier = frame.identifier;
+                frame.identifier = m_arena.make<NodeIdentifier>(NodeIdentifier{._identifier = node_array_index, ._access_token = nullptr});
+
+                frame.pending = ExpressionPending::_index;
+                m_expression_frames.push_back({1, 0});
+                return nullptr;
+            }
 
-            Token* op = &(*m_tokens_pointer);
-            int prec = getOperatorPrec(op);
-            bool right_assoc = isRightAssociative(op);
+            LOG_DEBUG("found _open_paren");
+            m_pos++;
+            NodeFunctionCall* function_call = m_arena.make<NodeFunctionCall>();
+            function_call->_identifier = frame.identifier;
+            frame.identifier = m_arena.make<NodeIdentifier>(NodeIdentifier{._identifier = function_call, ._access_token = nullptr});
 
-            if (prec < min_precedence) {
-                break;
+            if (_isTokenType(TokenType::_close_paren)) {
+                m_pos++;
+                continue;
+            }
+
+            frame.pending = ExpressionPending::_call;
+            m_expression_frames.push_back({0, 1});
+            return nullptr;
+        }
+
+        NodeExpression* lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = frame.identifier});
+        frame.identifier = nullptr;
+        LOG_DEBUG("Added identifier");
+
+        if (!frame.is_tuple_assignment && _isTokenType(TokenType::_comma)) {
+            m_pos++;
+            NodeTuple* node_tuple = m_arena.make<NodeTuple>();
+            node_tuple->_expressions.push_back(lhs);
+
+            frame.pending = ExpressionPending::_tuple;
+            frame.lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = node_tuple});
+            m_expression_frames.push_back({0, 1});
+            return nullptr;
+        }
+        return lhs;
+    }
+
+    /*
+        if the next token is an operator binding tightly enough for the
+        innermost frame, consumes it and pushes a frame for its rhs
+    */
+    bool parseOperator(NodeExpression* lhs) {
+        // every operator kind counts, as the lhs of a binary one if nothing else
+        const OperatorInfo& info = operatorInfo(m_tokens.kind(m_pos));
+        ExpressionFrame& frame = m_expression_frames.back();
+        if (!info.flags || info.precedence < frame.min_precedence) {
+            return false;
+        }
+
+        LOG_DEBUG("found an operator");
+        frame.pending = ExpressionPending::_rhs;
+        frame.lhs = lhs;
+        frame.op = peekToken();
+        m_pos++;
+
+        m_expression_frames.push_back({info.right_associative ? info.precedence : info.precedence + 1, 0});
+        return true;
+    }
+
+    /*
+        hands `inner`, the expression a finished frame produced, to the frame
+        that was waiting on it and returns that frame's lhs. Returns nullptr
+        instead if the frame pushed another one for its next item.
+    */
+    NodeExpression* resumeExpression(NodeExpression* inner) {
+        ExpressionFrame& frame = m_expression_frames.back();
+        ExpressionPending pending = frame.pending;
+        frame.pending = ExpressionPending::_none;
+
+        if (pending == ExpressionPending::_paren) {
+            if (frame.is_tuple_assignment == -1 || !_isTokenType(TokenType::_comma)) {
+                if (_isTokenType(TokenType::_close_paren)) {
+                    m_pos++;
+                }
+                return inner;
             }
 
-            m_tokens_pointer++;
+            m_pos++;
+            NodeTuple* node_tuple = m_arena.make<NodeTuple>();
+            node_tuple->_expressions.push_back(inner);
 
-            int next_min_prec = right_assoc ? prec : prec + 1;
+            int is_tuple_assignment = frame.is_tuple_assignment;
+            frame.pending = ExpressionPending::_paren_tuple;
+            frame.lhs = m_arena.make<NodeExpression>(NodeExpression{._expression = node_tuple});
+            m_expression_frames.push_back({0, is_tuple_assignment});
+            return nullptr;
+        }
 
-            NodeExpression* rhs = parseExpression(next_min_prec);
+        // items until one is missing, with or without commas between them
+        if (pending == ExpressionPending::_tuple || pending == ExpressionPending::_paren_tuple || pending == ExpressionPending::_list) {
+            if (inner) {
+                if (pending == ExpressionPending::_list) {
+                    std::get<NodeList*>(frame.lhs->_expression)->_items.push_back(inner);
+                } else {
+                    std::get<NodeTuple*>(frame.lhs->_expression)->_expressions.push_back(inner);
+                }
 
-            if (!rhs) {
-                printError("Expected expression in rhs", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                // a parenthesized tuple is parsed the way the parenthesis was, a bare one as a tuple assignment
+                int is_tuple_assignment = pending == ExpressionPending::_tuple ? 1 : pending == ExpressionPending::_list ? 0 : frame.is_tuple_assignment;
+                if (_isTokenType(TokenType::_comma)) {
+                    m_pos++;
+                }
+
+                frame.pending = pending;
+                m_expression_frames.push_back({0, is_tuple_assignment});
+                return nullptr;
             }
-            
-            if (op->getTokenType() == TokenType::_dbl_period) {
-                NodeRange* range = new NodeRange();
-                range->_start = lhs;
-                range->_end   = rhs;
-                
-                lhs = new NodeExpression{._expression = range};
-                continue;
+
+            if (pending == ExpressionPending::_list) {
+                parseToken(TokenType::_close_square);
+                LOG_DEBUG("Added list");
+            } else if (pending == ExpressionPending::_paren_tuple && _isTokenType(TokenType::_close_paren)) {
+                m_pos++;
             }
-            
-            NodeExpressionBinary* bin = new NodeExpressionBinary();
-            bin->_lhs = lhs;
-            bin->_operator = new NodeOperator{._token = op};
-            bin->_rhs = rhs;
+            return frame.lhs;
+        }
 
-            lhs = new NodeExpression{._expression = bin};
+        if (pending == ExpressionPending::_index) {
+            std::get<NodeArrayIndex*>(frame.identifier->_identifier)->_expression = inner;
+            parseToken(TokenType::_close_square);
+            return parseIdentifierSuffix();
         }
 
-        printDebug("returning expression");
-        return lhs;
-    }
+        if (pending == ExpressionPending::_call) {
+            if (!inner) {
+                printError("Expected call argument", peekToken()->getLine(), peekToken()->getChar());
+            }
+
+            NodeFunctionCall* function_call = std::get<NodeFunctionCall*>(frame.identifier->_identifier);
+            function_call->_arguments.push_back(m_arena.make<NodeFunctionCallArgument>(NodeFunctionCallArgument{._expression = inner}));
+            LOG_DEBUG("parsed call argument");
 
-    NodeList* parseList() {
-        printDebug("parsing list");
-        NodeList* node_list = new NodeList();
-        NodeExpression* node_expression = new NodeExpression();
-        while (node_expression = parseExpression()) {
-            node_list->_items.push_back(node_expression);
-            
             if (_isTokenType(TokenType::_comma)) {
-                m_tokens_pointer++;
+                m_pos++;
+                frame.pending = ExpressionPending::_call;
+                m_expression_frames.push_back({0, 1});
+                return nullptr;
+            }
+
+            if (!_isTokenType(TokenType::_close_paren)) {
+                printError("Expected `)` or `,` but got" + std::string(peekToken()->getStrValue()), peekToken()->getLine(), peekToken()->getChar());
             }
+            m_pos++;
+            return parseIdentifierSuffix();
+        }
+
+        if (pending == ExpressionPending::_prefix) {
+            if (!inner) {
+                printError("Expected expression", peekToken()->getLine(), peekToken()->getChar());
+            }
+
+            NodeExpressionUnary* node_expression_unary = m_arena.make<NodeExpressionUnary>();
+            node_expression_unary->_operator = m_arena.make<NodeOperator>(NodeOperator{._token = frame.op});
+            node_expression_unary->_expression = inner;
+            frame.lhs->_expression = node_expression_unary;
+            LOG_OK("parsed unary expression");
+            return frame.lhs;
         }
 
-        return node_list;
+        if (!inner) {
+            printError("Expected expression in rhs", peekToken()->getLine(), peekToken()->getChar());
+        }
+
+        if (frame.op->getTokenType() == TokenType::_dbl_period) {
+            NodeRange* range = m_arena.make<NodeRange>();
+            range->_start = frame.lhs;
+            range->_end   = inner;
+            return m_arena.make<NodeExpression>(NodeExpression{._expression = range});
+        }
+
+        NodeExpressionBinary* bin = m_arena.make<NodeExpressionBinary>();
+        bin->_lhs = frame.lhs;
+        bin->_operator = m_arena.make<NodeOperator>(NodeOperator{._token = frame.op});
+        bin->_rhs = inner;
+        return m_arena.make<NodeExpression>(NodeExpression{._expression = bin});
     }
 
     int parseSemi() {
         if (_isTokenType(TokenType::_semi)) {
-            m_tokens_pointer++;
-            printOk("completed a statement");
+            m_pos++;
+            LOG_OK("completed a statement");
             return 1;
 
         } else {
-            printError("Expected `;` but got " + m_tokens_pointer->getStrValue(), m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+            printError("Expected `;` but got " + std::string(peekToken()->getStrValue()), peekToken()->getLine(), peekToken()->getChar());
             return 0;
 
         }
     }
 
     NodeTypeTuple* parseTypeTuple(int raise_error = 0) {
-        NodeTypeTuple* node_type_tuple = new NodeTypeTuple();
+        NodeTypeTuple* node_type_tuple = m_arena.make<NodeTypeTuple>();
         if (_isTokenType(TokenType::_open_paren)) {
-            m_tokens_pointer++;
+            m_pos++;
 
             while (NodeType* node_type = parseType()) {
                 node_type_tuple->_types.push_back(node_type);
                 if (_isTokenType(TokenType::_comma)) {
-                    m_tokens_pointer++;
+                    m_pos++;
                 }
             }
 
             if (!_isTokenType(TokenType::_close_paren)) {
                 if (raise_error) {
-                    printError("Expected `)`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                    printError("Expected `)`", peekToken()->getLine(), peekToken()->getChar());
                 } else {
-                    printDebug("returning null");
+                    LOG_DEBUG("returning null");
                     node_type_tuple = nullptr;
                 }
             } else {
-                m_tokens_pointer++;
+                m_pos++;
             }
 
         } else if (raise_error) {
-            printError("Expected in parse tuple `(`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+            printError("Expected in parse tuple `(`", peekToken()->getLine(), peekToken()->getChar());
         }
 
         return node_type_tuple;
@@ -1120,32 +1531,33 @@ private:
 
     Token* parseToken(TokenType token_type) {
         expect(token_type);
-        Token* token = &*m_tokens_pointer++;
+        Token* token = peekToken();
+        m_pos++;
         return token;
     }
 
     NodeDecleration* parseDecleration() {
-        printDebug("parseDecleration");
+        LOG_DEBUG("parseDecleration");
 
-        NodeDecleration* decleration = new NodeDecleration();
+        NodeDecleration* decleration = m_arena.make<NodeDecleration>();
         bool is_decleration = false;
         bool is_struct_decleration = false;
 
         // parse qualifier
-        printDebug("checking for qualifier at " + std::to_string(m_tokens_pointer - m_tokens.begin()));
-        if (isQualifier(&(*m_tokens_pointer))) {
-            printOk("found qualifier");
+        LOG_DEBUG("checking for qualifier at " + std::to_string(m_pos));
+        if (isQualifier(peekToken())) {
+            LOG_OK("found qualifier");
             decleration->_qualifier = parseQualifer();
-            printDebug(decleration->_qualifier->_token->getStrValue());
+            LOG_DEBUG(std::string(decleration->_qualifier->_token->getStrValue()));
             is_decleration = true;
         }
 
         // parse type
-        printDebug("checking for type at " + std::to_string(m_tokens_pointer - m_tokens.begin()));
+        LOG_DEBUG("checking for type at " + std::to_string(m_pos));
         if (_isTokenType(TokenType::_struct)) {
-            NodeStruct* node_struct = new NodeStruct();
-            printOk("found struct");
-            m_tokens_pointer++;
+            NodeStruct* node_struct = m_arena.make<NodeStruct>();
+            LOG_OK("found struct");
+            m_pos++;
 
             NodeIdentifier* type = parseIdentifier(false, -1);
             node_struct->_type = type;
@@ -1155,62 +1567,62 @@ private:
             }
 
             NodeIdentifierToken* token = std::get<NodeIdentifierToken*>(type->_identifier);
-            m_types.push_back(token->_token->getStrValue());
-            printOk("found type for struct");
+            m_types->declare(token->_token);
+            LOG_OK("found type for struct");
 
-            node_struct->_arguments = parseFunctionDeclerationArguments(new bool(false));
-            printOk("found parseFunctionDeclerationArguments");
+            node_struct->_arguments = parseFunctionDeclerationArguments(false);
+            LOG_OK("found parseFunctionDeclerationArguments");
             is_struct_decleration = true;
             decleration->_type = node_struct;
 
-        } else if ((_isTokenType(TokenType::_identifier) && _isTokenType(TokenType::_identifier, 1)) || isType(&*m_tokens_pointer)) {
-            m_types.push_back(m_tokens_pointer->getStrValue());
+        } else if ((_isTokenType(TokenType::_identifier) && _isTokenType(TokenType::_identifier, 1)) || isType(peekToken())) {
+            m_types->declare(peekToken());
             decleration->_type = parseType(1);
-            printOk("found type");
+            LOG_OK("found type");
             is_decleration = true;
         }
 
-        printDebug("checking for identifier at " + std::to_string(m_tokens_pointer - m_tokens.begin()));
-        printDebug(m_tokens_pointer->getStrValue());
+        LOG_DEBUG("checking for identifier at " + std::to_string(m_pos));
+        LOG_DEBUG(std::string(peekToken()->getStrValue()));
         if (_isTokenType(TokenType::_identifier)) {
             is_decleration = true;
             decleration->_identifier = parseIdentifier(true);
             
-            printOk("parsed NodeIdentifier");
+            LOG_OK("parsed NodeIdentifier");
 
             if (decleration->_identifier && _isTokenType(TokenType::_comma)) {
-                printDebug("holds NodeIdentifier");
+                LOG_DEBUG("holds NodeIdentifier");
 
                 NodeIdentifier* node_identifier = decleration->_identifier;
                 
-                NodeTupleIdentifier* node_tuple_identifier = new NodeTupleIdentifier();
+                NodeTupleIdentifier* node_tuple_identifier = m_arena.make<NodeTupleIdentifier>();
                 node_tuple_identifier->_identifiers.push_back(node_identifier);
 
                 while (_isTokenType(TokenType::_comma)) {
-                    m_tokens_pointer++;
+                    m_pos++;
                     node_tuple_identifier->_identifiers.push_back(parseIdentifier(true, 0));
                 } 
 
                 if (node_tuple_identifier->_identifiers.size() >= 2) {
-                    decleration->_identifier = new NodeIdentifier{._identifier = node_tuple_identifier};
-                    printDebug("tuple");
+                    decleration->_identifier = m_arena.make<NodeIdentifier>(NodeIdentifier{._identifier = node_tuple_identifier});
+                    LOG_DEBUG("tuple");
                 }
             }
 
             else {
-                printDebug("Single");
-                printDebug(std::get<NodeIdentifierToken*>(decleration->_identifier->_identifier)->_token->getStrValue());
+                LOG_DEBUG("Single");
+                LOG_DEBUG(std::string(std::get<NodeIdentifierToken*>(decleration->_identifier->_identifier)->_token->getStrValue()));
             }
 
 
             if (_isTokenType(TokenType::_assign)) {
-                printOk("found assign");
+                LOG_OK("found assign");
 
-                int temp_line = m_tokens_pointer->getLine();
-                int temp_char = m_tokens_pointer->getChar();
-                m_tokens_pointer++;
+                int temp_line = peekToken()->getLine();
+                int temp_char = peekToken()->getChar();
+                m_pos++;
 
-                printDebug("need to parse expression...");
+                LOG_DEBUG("need to parse expression...");
                 if ( !(decleration->_expression = parseExpression()) ) {
                     printError("Expected <expression>", temp_line, temp_char);
                     return decleration;
@@ -1229,169 +1641,239 @@ private:
         return nullptr;
     }
 
-    NodeBlock* parseBlock() {
-        NodeBlock* node_block = new NodeBlock();
-        if (_isTokenType(TokenType::_open_curly)) {
-            m_tokens_pointer++;
+    /*
+        parses `= expression` after `lhs`, the caller has checked the `=` is there
+    */
+    NodeAssign* parseAssign(NodeExpression* lhs) {
+        LOG_DEBUG("parsing assign");
+        NodeAssign* assign = m_arena.make<NodeAssign>();
+        assign->_lhs = lhs;
 
-            printDebug("Opening a block");
-            
-            while (!_isTokenType(TokenType::_close_curly)) {
-                node_block->_elements.push_back(parseElement());
-            }
-            
-            m_tokens_pointer++;
-        }
+        assign->_operator = m_arena.make<NodeOperator>();
+        assign->_operator->_token = peekToken();
+        m_pos++;
 
-        return node_block;
+        assign->_rhs = parseExpression();
+        return assign;
     }
 
-    NodeAssign* parseAssign() {
-        NodeAssign* assign = new NodeAssign();
-        auto save = m_tokens_pointer;
-
-        if (_isTokenType(TokenType::_identifier)) {
-            NodeExpression* left = parseExpression();
-
-            if (_isTokenType(TokenType::_assign)) {
-                printDebug("parsing assign");
+    /*
+        parses a statement. Blocks, ifs and loops push a StatementFrame while
+        their bodies are parsed rather than recursing into them.
+    */
+    NodeStatement* parseStatement() {
+        std::size_t base = m_statement_frames.size();
 
-                assign->_lhs = left;
+        while (true) {
+            NodeStatement* statement = openStatement();
 
-                assign->_operator = new NodeOperator();
-                assign->_operator->_token = &*m_tokens_pointer;
-                m_tokens_pointer++;
-                
-                NodeExpression* right = parseExpression();
-                assign->_rhs = right;
-                return assign;
+            // hand finished statements outwards until a frame asks for its next body
+            while (true) {
+                if (m_statement_frames.size() == base) {
+                    LOG_DEBUG("Returning statement");
+                    return statement;
+                }
 
+                if (resumeStatement(statement)) {
+                    break;
+                }
             }
         }
-        
-        m_tokens_pointer = save;
-        return nullptr;
     }
 
-    NodeStatement* parseStatement() {
-        NodeStatement* statement = new NodeStatement();
+    /*
+        parses the next statement if it is a simple one. For a block, if or
+        loop it parses the part before the first body, pushes a frame and
+        returns nullptr.
+    */
+    NodeStatement* openStatement() {
+        NodeStatement* statement = m_arena.make<NodeStatement>();
 
         if (_isTokenType(TokenType::_if)) {
-
-            printDebug("parsing if block");
+            LOG_DEBUG("parsing if block");
             
-            NodeControl* node_control = new NodeControl();
-            m_tokens_pointer++; // consume if
-            bool if_block = true;
-            do {
-                if (_isTokenType(TokenType::_else) && _isTokenType(TokenType::_if, 1)) {
-                    m_tokens_pointer += 2;
-                }
-
-                printDebug("looping through ifs");
-                parseToken(TokenType::_open_paren);
-
-                NodeExpression* node_expression = parseExpression();
-                if (!node_expression) {
-                    printError("Expected expression for conditional statements");
-                }
-                printExpression(node_expression, 1);
-
-                parseToken(TokenType::_close_paren);
-
-                NodeStatement* node_statement = parseStatement();
-                if (!node_statement) {
-                    printError("Expected body for if statement");
-                }
-                printOk("found statement");
-
-                if (if_block) {
-                    node_control->_if = { node_expression, node_statement };
-                    printOk("found if");
-                    if_block = false;
-                } else {
-                    node_control->_else_if.push_back({ node_expression, node_statement });
-                    printOk("found elseif");
-                }
+            NodeControl* node_control = m_arena.make<NodeControl>();
+            statement->_statement = node_control;
+            m_pos++; // consume if
 
-            } while (m_tokens_pointer->getTokenType() == TokenType::_else && (m_tokens_pointer + 1)->getTokenType() == TokenType::_if);
+            m_statement_frames.push_back({StatementPending::_if, statement, parseCondition()});
+            return nullptr;
 
-            if (_isTokenType(TokenType::_else)) {
-                m_tokens_pointer++;
-                node_control->_statement_else = parseStatement();
-            }
-            
-            statement->_statement = node_control;
-            printOk("parsed control statement");
-            
         } else if (_isTokenType(TokenType::_else)) {
-            printError("expected if block but got `else`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+            printError("expected if block but got `else`", peekToken()->getLine(), peekToken()->getChar());
         }
 
         else if (_isTokenType(TokenType::_loop)) {
-            NodeLoop* node_loop = new NodeLoop();
-            node_loop->_predicated = new bool(0);
-            printDebug("parsing loop");
-            m_tokens_pointer++;
+            NodeLoop* node_loop = m_arena.make<NodeLoop>();
+            node_loop->_predicated = false;
+            statement->_statement = node_loop;
+            LOG_DEBUG("parsing loop");
+            m_pos++;
             
             if (_isTokenType(TokenType::_while)) {
-                printDebug("found while");
-                node_loop->_predicated = new bool(1);
-                m_tokens_pointer++;
+                LOG_DEBUG("found while");
+                node_loop->_predicated = true;
+                m_pos++;
 
                 if (_isTokenType(TokenType::_open_paren)) {
-                    m_tokens_pointer++;
+                    m_pos++;
                     node_loop->_expression = parseExpression();
                     if (!_isTokenType(TokenType::_close_paren)) {
-                        printError("Expected in while `)`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                        printError("Expected in while `)`", peekToken()->getLine(), peekToken()->getChar());
                     } else {
-                        m_tokens_pointer++;
-                        printDebug("closed expression");
+                        m_pos++;
+                        LOG_DEBUG("closed expression");
                     }
                 } else {
-                    printError("Expected in while `(`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                    printError("Expected in while `(`", peekToken()->getLine(), peekToken()->getChar());
+                }
+            }
+
+            m_statement_frames.push_back({StatementPending::_loop, statement});
+            return nullptr;
+        }
+
+        else if (_isTokenType(TokenType::_open_curly)) {
+            m_pos++;
+            LOG_DEBUG("Opening a block");
+
+            statement->_statement = m_arena.make<NodeBlock>();
+            m_statement_frames.push_back({StatementPending::_block, statement});
+            return nullptr;
+        }
+
+        else {
+            parseSimpleStatement(statement);
+        }
+
+        return statement;
+    }
+
+    /*
+        parses `( expression )` at the head of an if or else if
+    */
+    NodeExpression* parseCondition() {
+        LOG_DEBUG("looping through ifs");
+        parseToken(TokenType::_open_paren);
+
+        NodeExpression* node_expression = parseExpression();
+        if (!node_expression) {
+            printError("Expected expression for conditional statements");
+        }
+        if (logEnabled(LogLevel::debug)) {
+            printExpression(node_expression, 1);
+        }
+
+        parseToken(TokenType::_close_paren);
+        return node_expression;
+    }
+
+    /*
+        hands `inner`, a finished statement or nullptr for a frame that was
+        just pushed, to the innermost frame. Returns true if that frame needs
+        another body parsed, otherwise pops it and sets `inner` to its statement.
+    */
+    bool resumeStatement(NodeStatement*& inner) {
+        StatementFrame& frame = m_statement_frames.back();
+
+        if (frame.pending == StatementPending::_block) {
+            NodeBlock* node_block = std::get<NodeBlock*>(frame.statement->_statement);
+            if (inner) {
+                node_block->_elements.push_back(m_arena.make<NodeProgramElement>(NodeProgramElement{._element = inner}));
+            }
+
+            while (!_isTokenType(TokenType::_close_curly)) {
+                if (!_isTokenType(TokenType::_function) && !_isTokenType(TokenType::_procedure)) {
+                    return true;
                 }
+                node_block->_elements.push_back(parseElement());
+            }
+
+            m_pos++;
+            LOG_OK("parsed a block");
+
+        } else if (frame.pending == StatementPending::_loop) {
+            if (!inner) {
+                return true;
             }
 
-            printDebug("parsing statement 123");
-            node_loop->_statement = parseStatement();
-            printDebug("parsed statement 123");
+            NodeLoop* node_loop = std::get<NodeLoop*>(frame.statement->_statement);
+            node_loop->_statement = inner;
 
             if (_isTokenType(TokenType::_while)) {
-                if (!*node_loop->_predicated) {
-                    m_tokens_pointer++;
+                if (!node_loop->_predicated) {
+                    m_pos++;
 
                     node_loop->_expression = parseExpression();
                     parseSemi();
                 
                 } else {
-                    printError("Unexpected `while`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                    printError("Unexpected `while`", peekToken()->getLine(), peekToken()->getChar());
                 }
             }
 
-            statement->_statement = node_loop;
-        }
+        } else {
+            if (!inner) {
+                return true;
+            }
 
-        else if (_isTokenType(TokenType::_open_curly)) {
-            statement->_statement = parseBlock();
-            printOk("parsed a block");
+            NodeControl* node_control = std::get<NodeControl*>(frame.statement->_statement);
+            if (frame.pending == StatementPending::_else) {
+                node_control->_statement_else = inner;
+
+            } else {
+                LOG_OK("found statement");
+                if (!node_control->_if.first) {
+                    node_control->_if = { frame.condition, inner };
+                    LOG_OK("found if");
+                } else {
+                    node_control->_else_if.push_back({ frame.condition, inner });
+                    LOG_OK("found elseif");
+                }
+
+                if (_isTokenType(TokenType::_else) && _isTokenType(TokenType::_if, 1)) {
+                    m_pos += 2;
+                    frame.condition = parseCondition();
+                    inner = nullptr;
+                    return true;
+                }
+
+                if (_isTokenType(TokenType::_else)) {
+                    m_pos++;
+                    frame.pending = StatementPending::_else;
+                    inner = nullptr;
+                    return true;
+                }
+            }
+
+            LOG_OK("parsed control statement");
         }
 
-        else if (_isTokenType(TokenType::_break) || _isTokenType(TokenType::_continue)) {
-            NodeStatementToken* node_statement_token = new NodeStatementToken();
-            node_statement_token->_token = &(*m_tokens_pointer);
+        // a nested function body can have grown the frame stack, `frame` may have moved
+        inner = m_statement_frames.back().statement;
+        m_statement_frames.pop_back();
+        return false;
+    }
+
+    /*
+        parses a statement that has no statement nested in it into `statement`
+    */
+    void parseSimpleStatement(NodeStatement* statement) {
+        if (_isTokenType(TokenType::_break) || _isTokenType(TokenType::_continue)) {
+            NodeStatementToken* node_statement_token = m_arena.make<NodeStatementToken>();
+            node_statement_token->_token = peekToken();
 
             statement->_statement = node_statement_token;
-            m_tokens_pointer++;
+            m_pos++;
             parseSemi();
         }
 
         else if (_isTokenType(TokenType::_return)) {
             
-            NodeReturn* node_return = new NodeReturn();
-            node_return->_token = &(*m_tokens_pointer);
-            m_tokens_pointer++;
-            if (m_tokens_pointer->getTokenType() != TokenType::_semi) {
+            NodeReturn* node_return = m_arena.make<NodeReturn>();
+            node_return->_token = peekToken();
+            m_pos++;
+            if (peekToken()->getTokenType() != TokenType::_semi) {
                 node_return->_expression = parseExpression();
             }
             parseSemi();
@@ -1400,15 +1882,15 @@ private:
         }
 
         else if (_isTokenType(TokenType::_call)) {
-            printDebug("parsing `call`");
+            LOG_DEBUG("parsing `call`");
             
-            NodeCall* node_call = new NodeCall();
-            m_tokens_pointer++;
+            NodeCall* node_call = m_arena.make<NodeCall>();
+            m_pos++;
 
             if (_isTokenType(TokenType::_identifier)) {
-                printDebug("found identifier afer `call`");
+                LOG_DEBUG("found identifier afer `call`");
 
-                node_call->_function_call = new NodeFunctionCall();
+                node_call->_function_call = m_arena.make<NodeFunctionCall>();
                 node_call->_function_call->_identifier = parseIdentifier(true, 0);
                 if (!std::holds_alternative<NodeFunctionCall*>(node_call->_function_call->_identifier->_identifier)) {
                     printError("doesnt hold NodeFunctionCall");
@@ -1417,78 +1899,65 @@ private:
                 parseSemi();
                 statement->_statement = node_call;
             } else {
-                printError("Expected identifier after `call`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                printError("Expected identifier after `call`", peekToken()->getLine(), peekToken()->getChar());
             }
 
         }
 
-        else {
-            auto temp = m_tokens_pointer;
+        else if (isDecleration()) {
+            statement->_statement = parseDecleration();
+            LOG_OK("Decleration parsed");
+        }
 
+        else {
+            Token* start = peekToken();
             NodeExpression* expression = parseExpression();
-            if (expression != nullptr && (_isTokenType(TokenType::_stream_input) || _isTokenType(TokenType::_stream_output))) {
-
-                if (NodeStream* node_stream = parseStream(expression, 1)) {
-                    node_stream->_expression = expression;
-                    parseSemi();
 
-                    statement->_statement = node_stream;
-                    return statement;
-                }
-            } 
-            
-            m_tokens_pointer = temp;
-            if (_isTokenType(TokenType::_identifier)) {
-                m_tokens_pointer = temp;
-                NodeAssign* node_assign = parseAssign();
-                if (node_assign != nullptr) {
-                    parseSemi();
-                    statement->_statement = node_assign;
-                }
-            }
+            if (expression != nullptr && (_isTokenType(TokenType::_stream_input) || _isTokenType(TokenType::_stream_output))) {
+                NodeStream* node_stream = parseStream(expression, 1);
+                node_stream->_expression = expression;
+                parseSemi();
 
-            else {
-                m_tokens_pointer = temp;
-                NodeDecleration* declaration = parseDecleration();
+                statement->_statement = node_stream;
 
-                if (declaration) {
-                    printOk("Decleration parsed");
-                    statement->_statement = declaration;
-                }
+            } else if (expression != nullptr && start->getTokenType() == TokenType::_identifier && _isTokenType(TokenType::_assign)) {
+                statement->_statement = parseAssign(expression);
+                parseSemi();
 
-                else {
-                    m_tokens_pointer = temp;
-                    printError("Invalid statement", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
-                }
+            } else {
+                printError("Invalid statement", start->getLine(), start->getChar());
             }
-    
-
         }
-        
-        printDebug("Returning statement");
-        return statement;
+    }
+
+    /*
+        returns the token `next` positions away from the current one, past the end this is the `_eof` token
+    */
+    Token* peekToken(int next = 0) {
+        return &m_tokens.at(m_pos + next);
     }
 
     /*
         returns 1 if buffer meets the criteria to be an identifier otherwise 0
     */
     bool _isTokenType(TokenType token_type, int next = 0) {
-        return (m_tokens_pointer + next)->getTokenType() == token_type;
+        return m_tokens.kind(m_pos + next) == token_type;
     }
 
     NodeStream* parseStream(NodeExpression* expression, int raise_error=0) {
-        NodeStream* node_stream = new NodeStream();
+        NodeStream* node_stream = nullptr;
 
         if (
             (_isTokenType(TokenType::_stream_output) && _isTokenType(TokenType::_std_output, 1)) || 
             (_isTokenType(TokenType::_stream_input) && _isTokenType(TokenType::_std_input, 1) && std::holds_alternative<NodeIdentifier*>(expression->_expression))
         ) {
 
-            node_stream->_operator = &(*m_tokens_pointer);
-            node_stream->_destination = &(*(m_tokens_pointer + 1));
-            m_tokens_pointer += 2;
+            node_stream = m_arena.make<NodeStream>();
+            node_stream->_operator = peekToken();
+            node_stream->_destination = peekToken(1);
+            m_pos += 2;
 
-            printOk(std::string("Found an ") + std::string(_isTokenType(TokenType::_stream_output) ? "in" : "out") + std::string("put stream statement"));
+            LOG_OK(std::string("Found an ") + std::string(_isTokenType(TokenType::_stream_output) ? "in" : "out") + std::string("put stream statement"));
             
         } else if (raise_error) {
             printError("Found a stream statement but couldnt figure out which type");
@@ -1500,75 +1969,115 @@ private:
         return node_stream;
     } 
 
+    /*
+        Parses an identifier and its member access chain. `main` is 0 to
+        also parse `[` and `(` suffixes, 1 to leave them to the caller, -1 to
+        stop at the name. `a.b.c` nests as a, accessing b, accessing c. Every
+        identifier after a `.` is one AccessFrame on m_access_frames rather
+        than a recursive call, so the chain is only limited by memory.
+    */
     NodeIdentifier* parseIdentifier(bool raise_error=0, int main = 0) {
-        printDebug("parseIdentifier function");
+        LOG_DEBUG("parseIdentifier function");
 
-        if (_isTokenType(TokenType::_identifier)) {
-            printDebug("found identifier");
+        if (!_isTokenType(TokenType::_identifier)) {
+            if (raise_error) {
+                printError("Expected identifier", peekToken()->getLine(), peekToken()->getChar());
+            }
+            return nullptr;
+        }
 
-            NodeIdentifier* node_identifier = new NodeIdentifier();
-            NodeIdentifierToken* node_identifier_token = new NodeIdentifierToken();
-            node_identifier_token->_token = &(*m_tokens_pointer);
-            node_identifier->_identifier = node_identifier_token;
-            m_tokens_pointer++;
+        std::size_t base = m_access_frames.size();
+        m_access_frames.push_back(parseIdentifierToken(main));
+        NodeIdentifier* done = nullptr;
 
-            while (main != -1 && _isTokenType(TokenType::_period)) {
-                m_tokens_pointer++;
+        while (true) {
+            AccessFrame& frame = m_access_frames.back();
 
-                NodeIdentifier* new_identifier = new NodeIdentifier();
+            // the identifier after the `.` is done, it is what this one accesses
+            if (frame.access) {
+                frame.access->_access_token = done;
+                frame.identifier = frame.access;
+                frame.access = nullptr;
+            }
 
-                new_identifier->_identifier = node_identifier_token;
-                new_identifier->_access_token = parseIdentifier();
+            if (frame.main != -1 && _isTokenType(TokenType::_period)) {
+                m_pos++;
 
-                node_identifier = new_identifier;
-            }
+                frame.access = m_arena.make<NodeIdentifier>();
+                frame.access->_identifier = frame.token;
 
-            
-            if (main == 0) {
-                while (_isTokenType(TokenType::_open_square) || _isTokenType(TokenType::_open_paren)) {
-                    if (_isTokenType(TokenType::_open_square)) {
-
-                        printDebug("found _open_square");
-                        m_tokens_pointer++;
-                        NodeArrayIndex* node_array_index = new NodeArrayIndex();
-                        node_array_index->_identifier = node_identifier;
-                        node_array_index->_expression = parseExpression(1);
-                        
-                        parseToken(TokenType::_close_square);
-                        node_identifier = new NodeIdentifier {._identifier = node_array_index};
-                    }
-                    
-                    else if (_isTokenType(TokenType::_open_paren)) {
-                        printDebug("found _open_paren");
-
-                        std::vector<NodeFunctionCallArgument*> function_call_arguments = parseFunctionCallArguments();
-                        NodeFunctionCall* function_call = new NodeFunctionCall();
-                        function_call->_arguments = function_call_arguments;
-                        function_call->_identifier = node_identifier;
-                        
-                        node_identifier = new NodeIdentifier {._identifier = function_call};
-                        printDebug("Added function call with arguments: " + std::to_string(function_call_arguments.size()));
-
-                    } 
+                if (_isTokenType(TokenType::_identifier)) {
+                    m_access_frames.push_back(parseIdentifierToken(0));
+                } else {
+                    done = nullptr;
                 }
+                continue;
+            }
 
+            NodeIdentifier* node_identifier = frame.identifier;
+            if (frame.main == 0) {
+                node_identifier = parseCallAndIndexSuffixes(node_identifier);
             }
-            
 
-            printDebug("returning from parseIdentifier");
-            return node_identifier;
+            m_access_frames.pop_back();
+            done = node_identifier;
+            if (m_access_frames.size() == base) break;
         }
 
-        if (raise_error) {
-            printError("Expected identifier", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+        LOG_DEBUG("returning from parseIdentifier");
+        return done;
+    }
+
+    // the name at the current token, as the start of an AccessFrame
+    AccessFrame parseIdentifierToken(int main) {
+        LOG_DEBUG("found identifier");
+
+        NodeIdentifier* node_identifier = m_arena.make<NodeIdentifier>();
+        NodeIdentifierToken* node_identifier_token = m_arena.make<NodeIdentifierToken>();
+        node_identifier_token->_token = peekToken();
+        node_identifier->_identifier = node_identifier_token;
+        m_pos++;
+
+        return {.token = node_identifier_token, .identifier = node_identifier, .main = main};
+    }
+
+    // `[index]` and `(arguments)` after an identifier, any number of them
+    NodeIdentifier* parseCallAndIndexSuffixes(NodeIdentifier* node_identifier) {
+        while (_isTokenType(TokenType::_open_square) || _isTokenType(TokenType::_open_paren)) {
+            if (_isTokenType(TokenType::_open_square)) {
+
+                LOG_DEBUG("found _open_square");
+                m_pos++;
+                NodeArrayIndex* node_array_index = m_arena.make<NodeArrayIndex>();
+                node_array_index->_identifier = node_identifier;
+                node_array_index->_expression = parseExpression(1);
+                
+                parseToken(TokenType::_close_square);
+                node_identifier = m_arena.make<NodeIdentifier>(NodeIdentifier{._identifier = node_array_index});
+            }
+            
+            else if (_isTokenType(TokenType::_open_paren)) {
+                LOG_DEBUG("found _open_paren");
+
+                std::vector<NodeFunctionCallArgument*> function_call_arguments = parseFunctionCallArguments();
+                NodeFunctionCall* function_call = m_arena.make<NodeFunctionCall>();
+                function_call->_arguments = function_call_arguments;
+                function_call->_identifier = node_identifier;
+                
+                node_identifier = m_arena.make<NodeIdentifier>(NodeIdentifier{._identifier = function_call});
+                LOG_DEBUG("Added function call with arguments: " + std::to_string(function_call_arguments.size()));
+
+            } 
         }
 
-        return nullptr;
+        return node_identifier;
     }
 
     NodeQualifier* parseQualifer(int raise_error=0) {
-        if (isQualifier(&*m_tokens_pointer)) {
-            return new NodeQualifier{._token=&*m_tokens_pointer++};
+        if (isQualifier(peekToken())) {
+            NodeQualifier* node_qualifier = m_arena.make<NodeQualifier>(NodeQualifier{._token=peekToken()});
+            m_pos++;
+            return node_qualifier;
 
         } else if (raise_error) {
             printError("Expected qualifier");
@@ -1578,65 +2087,72 @@ private:
         return nullptr;
     }
 
-    NodeType* parseType(int raise_error=0) {
-        printDebug("parsing type...");
-        printDebug(m_tokens_pointer->getStrValue());
-        printDebug(std::to_string(isType(&*m_tokens_pointer)));
-        printDebug(std::to_string(m_typealias_map.size()));
-
-        if (isType(&*m_tokens_pointer)) {
-            printDebug("found type");
-            NodeType* node_type = new NodeType();
-            if (m_typealias_map.find(m_tokens_pointer->getStrValue()) != m_typealias_map.end()) {
-                printDebug("found typealias");
-                node_type = m_typealias_map[m_tokens_pointer->getStrValue()];
+    /*
+        Counts one more vector or tuple type around the one about to be
+        parsed. Types are parsed, flattened and printed recursively, so
+        their nesting is bounded like the generator bounds statements.
+    */
+    void enterNestedType() {
+        if (++m_type_depth > MAX_TYPE_DEPTH) {
+            printError("Types nested more than " + std::to_string(MAX_TYPE_DEPTH) + " levels deep are not supported",
+                peekToken()->getLine(), peekToken()->getChar());
+        }
+    }
 
-            } else {
-                printDebug("no typealias");
-                node_type = new NodeType{._type=&*m_tokens_pointer};
+    NodeType* parseType(int raise_error=0) {
+        LOG_DEBUG("parsing type...");
+        LOG_DEBUG(std::string(peekToken()->getStrValue()));
+        LOG_DEBUG(std::to_string(isType(peekToken())));
+        LOG_DEBUG(std::to_string(m_types->size()));
 
-            }
+        if (isType(peekToken())) {
+            LOG_DEBUG("found type");
+            NodeType* node_type = m_types->named(m_arena, peekToken());
 
-            m_tokens_pointer++;
+            m_pos++;
 
             while (_isTokenType(TokenType::_open_square)) {
-                m_tokens_pointer++;
-                NodeTypeArray* node_type_array = new NodeTypeArray();
+                m_pos++;
+                NodeInteger* size = nullptr;
                 if (!_isTokenType(TokenType::_asterisk)) {
-                    node_type_array->_index = parseInteger(1);
+                    size = parseInteger(1);
                 } else {
-                    m_tokens_pointer++;
+                    m_pos++;
                 }
 
                 if (!_isTokenType(TokenType::_close_square)) {
-                    printError("Expected `]`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                    printError("Expected `]`", peekToken()->getLine(), peekToken()->getChar());
                 } else {
-                    m_tokens_pointer++;
+                    m_pos++;
                 }
 
-                node_type_array->_type = node_type;
-                
-                node_type = new NodeType{._type = node_type_array};
+                node_type = m_types->array(m_arena, node_type, size);
             }
 
             if (_isTokenType(TokenType::_vector, -1)) {
                 
                 parseToken(TokenType::_less_than);
-                NodeTypeVector* node_type_vector = new NodeTypeVector();
-                node_type_vector->_type = parseType();
+                enterNestedType();
+                NodeType* element = parseType();
+                m_type_depth--;
                 parseToken(TokenType::_greater_than);
 
-                return new NodeType{._type = node_type_vector};
+                return m_types->vector(m_arena, element);
             }
 
             else if (_isTokenType(TokenType::_tuple, -1)) {
-                if (isQualifier(&*(m_tokens_pointer - 1))) {
+                if (isQualifier(peekToken(-1))) {
                     printError("tuple cant be declared with a qualifier");
                 }
 
-                printOk("found tuple");
+                LOG_OK("found tuple");
+                enterNestedType();
                 NodeTypeTuple* node_type_tuple = parseTypeTuple();
-                return new NodeType{._type = node_type_tuple};
+                m_type_depth--;
+                if (!node_type_tuple) {
+                    return m_arena.make<NodeType>(NodeType{._type = node_type_tuple});
+                }
+                return m_types->tuple(m_arena, node_type_tuple);
             }
 
             return node_type;
@@ -1648,32 +2164,32 @@ private:
         return nullptr;
     }
 
-    NodeFunctionDeclerationArgument* parseFunctionDeclerationArgument(bool* is_procedure) {
-        printDebug("parsing DeclerationArgument " + std::to_string(*is_procedure));
+    NodeFunctionDeclerationArgument* parseFunctionDeclerationArgument(bool is_procedure) {
+        LOG_DEBUG("parsing DeclerationArgument " + std::to_string(is_procedure));
         
-        if (!*is_procedure || isQualifier(&(*m_tokens_pointer))) {
-            NodeFunctionDeclerationArgument* node_argument = new NodeFunctionDeclerationArgument();
+        if (!is_procedure || isQualifier(peekToken())) {
+            NodeFunctionDeclerationArgument* node_argument = m_arena.make<NodeFunctionDeclerationArgument>();
 
-            if (*is_procedure) {
+            if (is_procedure) {
                 node_argument->_qualifier = parseQualifer(1);
             }
 
-            if (isType(&(*m_tokens_pointer))) {
+            if (isType(peekToken())) {
                 
                 node_argument->_type = parseType();
-                printOk("parsed type");
+                LOG_OK("parsed type");
 
-                if (m_tokens_pointer < m_tokens.end() && _isTokenType(TokenType::_identifier)) {
+                if (!_isTokenType(TokenType::_eof) && _isTokenType(TokenType::_identifier)) {
                     node_argument->_identifier = parseIdentifier(false, -1);
 
                 } else {
-                    printError("Expected identifier", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                    printError("Expected identifier", peekToken()->getLine(), peekToken()->getChar());
                 }
 
-                printDebug("parsed argument");
+                LOG_DEBUG("parsed argument");
                 return node_argument;
             } else {
-                printError("couldnt find type: " + m_tokens_pointer->getStrValue());
+                printError("couldnt find type: " + std::string(peekToken()->getStrValue()));
             }
 
         } else {
@@ -1682,40 +2198,39 @@ private:
         return nullptr;
     }
     
-    std::vector<NodeFunctionDeclerationArgument*> parseFunctionDeclerationArguments(bool* is_procedure) {
+    std::vector<NodeFunctionDeclerationArgument*> parseFunctionDeclerationArguments(bool is_procedure) {
         std::vector<NodeFunctionDeclerationArgument*> node_arguments;
-        if (m_tokens_pointer->getTokenType() != TokenType::_open_paren) {
-            printError("Expected parseFunctionDeclerationArguments `(`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+        if (peekToken()->getTokenType() != TokenType::_open_paren) {
+            printError("Expected parseFunctionDeclerationArguments `(`", peekToken()->getLine(), peekToken()->getChar());
         }
-        m_tokens_pointer++;
-        printDebug("found `(`");
+        m_pos++;
+        LOG_DEBUG("found `(`");
 
         if (_isTokenType(TokenType::_close_paren)) {
-            printDebug("found `)`");
-            m_tokens_pointer++;
+            LOG_DEBUG("found `)`");
+            m_pos++;
             return node_arguments;
         }
 
-        printDebug("parsing argument");
+        LOG_DEBUG("parsing argument");
         while (true) {
-            NodeFunctionDeclerationArgument* node_argument = new NodeFunctionDeclerationArgument();
-            node_argument = parseFunctionDeclerationArgument(is_procedure);
+            NodeFunctionDeclerationArgument* node_argument = parseFunctionDeclerationArgument(is_procedure);
             if (!node_argument) break;
 
             node_arguments.push_back(node_argument);
-            printDebug("parsed argument");
+            LOG_DEBUG("parsed argument");
             
             if (_isTokenType(TokenType::_comma)) {
-                printDebug("found comma");
-                m_tokens_pointer++;
+                LOG_DEBUG("found comma");
+                m_pos++;
 
             } else if (_isTokenType(TokenType::_close_paren)) {
-                printDebug("found `)`");
-                m_tokens_pointer++;
+                LOG_DEBUG("found `)`");
+                m_pos++;
                 return node_arguments;
                 
             } else {
-                printError("Expected `)` or `,`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                printError("Expected `)` or `,`", peekToken()->getLine(), peekToken()->getChar());
             }
         }
 
@@ -1724,12 +2239,10 @@ private:
     }
 
     NodeFunctionCallArgument* parseFunctionCallArgument() {
-        printDebug("parsing call argument");
-        NodeFunctionCallArgument* call_argument = new NodeFunctionCallArgument();
-
-        if (call_argument->_expression = parseExpression(0, 1)) {
-            printDebug("parsed call argument. next token: " + m_tokens_pointer->getStrValue());
-            return call_argument;
+        LOG_DEBUG("parsing call argument");
+        if (NodeExpression* expression = parseExpression(0, 1)) {
+            LOG_DEBUG("parsed call argument. next token: " + std::string(peekToken()->getStrValue()));
+            return m_arena.make<NodeFunctionCallArgument>(NodeFunctionCallArgument{._expression = expression});
         }
 
         return nullptr;
@@ -1737,39 +2250,38 @@ private:
 
     std::vector<NodeFunctionCallArgument*> parseFunctionCallArguments() {
         std::vector<NodeFunctionCallArgument*> call_arguments;
-        if (m_tokens_pointer->getTokenType() != TokenType::_open_paren) {
-            printError("Expected parseFunctionCallArguments `(`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+        if (peekToken()->getTokenType() != TokenType::_open_paren) {
+            printError("Expected parseFunctionCallArguments `(`", peekToken()->getLine(), peekToken()->getChar());
         }
 
-        m_tokens_pointer++;
-        printDebug("found `(`");
+        m_pos++;
+        LOG_DEBUG("found `(`");
 
         if (_isTokenType(TokenType::_close_paren)) {
-            printDebug("found `)`");
-            m_tokens_pointer++;
+            LOG_DEBUG("found `)`");
+            m_pos++;
             return call_arguments;
         }
 
-        printDebug("parsing call argument");
+        LOG_DEBUG("parsing call argument");
         while (true) {
-            NodeFunctionCallArgument* node_argument = new NodeFunctionCallArgument();
-            node_argument = parseFunctionCallArgument();
+            NodeFunctionCallArgument* node_argument = parseFunctionCallArgument();
             if (!node_argument) break;
 
             call_arguments.push_back(node_argument);
-            printDebug("parsed call argument");
+            LOG_DEBUG("parsed call argument");
             
             if (_isTokenType(TokenType::_comma)) {
-                printDebug("found comma");
-                m_tokens_pointer++;
+                LOG_DEBUG("found comma");
+                m_pos++;
 
             } else if (_isTokenType(TokenType::_close_paren)) {
-                printDebug("found `)`");
-                m_tokens_pointer++;
+                LOG_DEBUG("found `)`");
+                m_pos++;
                 return call_arguments;
                 
             } else {
-                printError("Expected `)` or `,` but got" + m_tokens_pointer->getStrValue(), m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                printError("Expected `)` or `,` but got" + std::string(peekToken()->getStrValue()), peekToken()->getLine(), peekToken()->getChar());
             }
         }
 
@@ -1778,95 +2290,134 @@ private:
     }
 
 
-    NodeFunctionDecleration* parseFunctionOrProcedure() {
-        NodeFunctionDecleration* node_function = new NodeFunctionDecleration();
-        bool* is_procedure = nullptr;
+    // `= expression;` or a block
+    void parseFunctionBody(NodeFunctionDecleration* node_function) {
+        if (!_isTokenType(TokenType::_eof) && _isTokenType(TokenType::_assign)) {
+            m_pos++;
+            LOG_DEBUG("parsing expression");
+
+            if (node_function->_expression = parseExpression()) {
+                LOG_DEBUG("parsed expression");
+                parseSemi();
+            } else {
+                printError("Expected expression", peekToken()->getLine(), peekToken()->getChar());
+            }
+
+        } else if (!_isTokenType(TokenType::_eof) && _isTokenType(TokenType::_open_curly)) {
+            LOG_DEBUG("parsed statement");
+
+            if (node_function->_statement = parseStatement()) {
+                LOG_DEBUG("parsed statement");
+            } else {
+                printError("Expected statement", peekToken()->getLine(), peekToken()->getChar());
+            }                    
+        } else {
+            printError("Invalid function body", peekToken()->getLine(), peekToken()->getChar());
+        }
+    }
+
+    /*
+        records where the body at the current token ends and moves past it
+        without parsing it, for parseBody() to do later. Returns false, and
+        leaves the body to be parsed now, if its end is not there to find.
+    */
+    bool skipFunctionBody(NodeFunctionDecleration* node_function) {
+        std::size_t end = m_pos;
+        if (_isTokenType(TokenType::_assign)) {
+            while (m_tokens.kind(end) != TokenType::_semi && m_tokens.kind(end) != TokenType::_eof) end++;
+
+        } else if (_isTokenType(TokenType::_open_curly)) {
+            for (int depth = 0; m_tokens.kind(end) != TokenType::_eof; end++) {
+                if (m_tokens.kind(end) == TokenType::_open_curly) depth++;
+                if (m_tokens.kind(end) == TokenType::_close_curly && --depth == 0) break;
+            }
+        }
+
+        if (end == m_pos || m_tokens.kind(end) == TokenType::_eof) {
+            return false;
+        }
+
+        node_function->_body_start = m_pos;
+        node_function->_body_end = end + 1;
+        m_pos = end + 1;
+        return true;
+    }
+
+    NodeFunctionDecleration* parseFunctionOrProcedure(bool lazy = false) {
+        NodeFunctionDecleration* node_function = m_arena.make<NodeFunctionDecleration>();
+        std::size_t start = m_pos;
+        bool is_procedure = false;
 
         if (_isTokenType(TokenType::_function) || _isTokenType(TokenType::_procedure)) {
-            printDebug(std::to_string(_isTokenType(TokenType::_procedure)));
+            LOG_DEBUG(std::to_string(_isTokenType(TokenType::_procedure)));
 
             if (_isTokenType(TokenType::_function)) {
-                printDebug("parsing function");
-                is_procedure = new bool(false);
+                LOG_DEBUG("parsing function");
+                is_procedure = false;
             } else {
-                printDebug("parsing procedure");
-                is_procedure = new bool(true);
-                printDebug("set is_procedure to false");
+                LOG_DEBUG("parsing procedure");
+                is_procedure = true;
+                LOG_DEBUG("set is_procedure to false");
             }
 
-            m_tokens_pointer++;
+            m_pos++;
 
-            printDebug("parsing identifier");
+            LOG_DEBUG("parsing identifier");
             node_function->_identifier = parseIdentifier(true, -1);
             if (node_function->_identifier) {
-                printDebug("parsed identifier");
+                LOG_DEBUG("parsed identifier");
 
-                printDebug("parsing arguments");
+                LOG_DEBUG("parsing arguments");
                 node_function->_arguments = parseFunctionDeclerationArguments(is_procedure);
-                printDebug("parsed arguments: " + std::to_string((node_function->_arguments).size()));
+                LOG_DEBUG("parsed arguments: " + std::to_string((node_function->_arguments).size()));
 
-                if (m_tokens_pointer->getTokenType() != TokenType::_returns) {
-                    if (is_procedure && *is_procedure == false) {
-                        printError("Expected `returns`", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                if (peekToken()->getTokenType() != TokenType::_returns) {
+                    if (is_procedure == false) {
+                        printError("Expected `returns`", peekToken()->getLine(), peekToken()->getChar());
                     }
 
                 } else {
-                    m_tokens_pointer++;
+                    m_pos++;
 
-                    if (m_tokens_pointer < m_tokens.end() && isType(&(*m_tokens_pointer))) {
+                    if (!_isTokenType(TokenType::_eof) && isType(peekToken())) {
                         node_function->_return_type = parseType();
 
                     } else {
-                        printError("Expected type", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                        printError("Expected type", peekToken()->getLine(), peekToken()->getChar());
                     }
                 }
 
 
-                if (m_tokens_pointer < m_tokens.end() && _isTokenType(TokenType::_assign)) {
-                    m_tokens_pointer++;
-                    printDebug("parsing expression");
-
-                    if (node_function->_expression = parseExpression()) {
-                        printDebug("parsed expression");
-                        parseSemi();
-                    } else {
-                        printError("Expected expression", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
-                    }
-
-                } else if (m_tokens_pointer < m_tokens.end() && _isTokenType(TokenType::_open_curly)) {
-                    printDebug("parsed statement");
-
-                    if (node_function->_statement = parseStatement()) {
-                        printDebug("parsed statement");
-                    } else {
-                        printError("Expected statement", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
-                    }                    
-                } else {
-                    printError("Invalid function body", m_tokens_pointer->getLine(), m_tokens_pointer->getChar());
+                if (!lazy || !skipFunctionBody(node_function)) {
+                    parseFunctionBody(node_function);
                 }
 
-                printDebug("parsed function");
+                LOG_DEBUG("parsed function");
             }
         } else {
             printError("Shouldnt reach here");
         }
 
-        node_function->is_procedure = new bool(*is_procedure);
+        node_function->is_procedure = is_procedure;
+        if (node_function->_body_end) {
+            m_lazy_functions.push_back({start, node_function});
+        }
         return node_function;
     }
 
-    NodeProgramElement* parseElement() {
-        NodeProgramElement* node_program_element = new NodeProgramElement();
+    // `lazy` skips a function's body, see setLazyBodies()
+    NodeProgramElement* parseElement(bool lazy = false) {
+        NodeProgramElement* node_program_element = m_arena.make<NodeProgramElement>();
         if (_isTokenType(TokenType::_function) || _isTokenType(TokenType::_procedure)) {
-            printDebug("parsing function or procedure...");
-            NodeFunctionDecleration* function_decleration = parseFunctionOrProcedure();
+            LOG_DEBUG("parsing function or procedure...");
+            NodeFunctionDecleration* function_decleration = parseFunctionOrProcedure(lazy);
             if (!function_decleration) return nullptr;
 
             node_program_element->_element = function_decleration;
         }        
                 
         else {
-            printDebug("parsing statement in parseElement...");
+            LOG_DEBUG("parsing statement in parseElement...");
             NodeStatement* statement = parseStatement();
             if (!statement) return nullptr;
 
@@ -1875,48 +2426,288 @@ private:
         return node_program_element;
     }
 
-    NodeProgram* parseProgram() {
-        printDebug("parsing program...");
-        
-        while (_isTokenType(TokenType::_typealias) && m_tokens_pointer < m_tokens.end()) {
+    // the `typealias` declarations a program opens with
+    void parseTypealiases() {
+        while (_isTokenType(TokenType::_typealias) && !_isTokenType(TokenType::_eof)) {
             parseToken(TokenType::_typealias);
-            NodeTypealias* node_typealias = new NodeTypealias();
+            NodeTypealias* node_typealias = m_arena.make<NodeTypealias>();
             node_typealias->_original = parseType(1);
             node_typealias->_new = parseToken(TokenType::_identifier);
-            m_types.push_back(node_typealias->_new->getStrValue());
-            m_typealias_map[node_typealias->_new->getStrValue()] = node_typealias->_original;
+            m_types->alias(node_typealias->_new, node_typealias->_original);
             parseSemi();
 
-            NodeProgramElement* node_program_element = new NodeProgramElement{._element=node_typealias};
+            NodeProgramElement* node_program_element = m_arena.make<NodeProgramElement>(NodeProgramElement{._element=node_typealias});
             m_program->_elements.push_back(node_program_element);
         }
+    }
 
-        while (m_tokens_pointer < m_tokens.end()) {
-            if (NodeProgramElement* node_program_element = parseElement()) {
+    // top-level elements until the token at `end` or the end of the program
+    void parseElements(std::size_t end = SIZE_MAX) {
+        while (m_pos < end && !_isTokenType(TokenType::_eof)) {
+            if (NodeProgramElement* node_program_element = parseElement(m_lazy_bodies)) {
                 m_program->_elements.push_back(node_program_element);
             } else {
                 printError("Invalid element");
             }
         }
+    }
 
-        printOk("Program parsed");
+    NodeProgram* parseProgram() {
+        LOG_DEBUG("parsing program...");
+        parseTypealiases();
+        parseElements();
+
+        LOG_INFO("Program parsed");
         return m_program;
     }
 
+    // the first top-level function or procedure keyword from the current token on, or the `_eof` token
+    std::size_t findFirstFunction() {
+        std::size_t end = m_tokens.size() - 1;
+        int depth = 0;
+
+        for (std::size_t i = m_pos; i < end; i++) {
+            TokenType kind = m_tokens.kind(i);
+            if (kind == TokenType::_open_curly) {
+                depth++;
+            } else if (kind == TokenType::_close_curly) {
+                depth--;
+            } else if ((kind == TokenType::_function || kind == TokenType::_procedure) && depth == 0) {
+                return i;
+            }
+        }
+        return end;
+    }
+
+    /*
+        Pre-pass for parseParallel(). Finds the top-level functions and
+        procedures from the current token on, by their keyword outside any
+        braces, and returns the start of about `count` equally sized chunks,
+        each at one of them. The last entry is the `_eof` token.
+
+        Returns nothing if a chunk could declare a type name the ones after it
+        would see: a `struct`, or `T x` with T not yet a type. Everything
+        before the first function must have been parsed already, so the
+        types it declares count as declared.
+    */
+    std::vector<std::size_t> findFunctionBoundaries(std::size_t count) {
+        std::vector<std::size_t> boundaries;
+        std::size_t end = m_tokens.size() - 1;
+        std::size_t chunk_size = (end - m_pos) / std::max(count, std::size_t(1)) + 1;
+        std::size_t next_split = 0;
+        int depth = 0;
+
+        for (std::size_t i = m_pos; i < end; i++) {
+            TokenType kind = m_tokens.kind(i);
+            if (kind == TokenType::_open_curly) {
+                depth++;
+            } else if (kind == TokenType::_close_curly) {
+                depth--;
+            } else if ((kind == TokenType::_function || kind == TokenType::_procedure) && depth == 0 && i >= next_split) {
+                boundaries.push_back(i);
+                next_split = i + chunk_size;
+            }
+
+            if (boundaries.empty()) continue;
+
+            if (kind == TokenType::_struct ||
+                (kind == TokenType::_identifier && m_tokens.kind(i + 1) == TokenType::_identifier && !m_types->isDeclared(&m_tokens.at(i)))) {
+                return {};
+            }
+        }
+
+        boundaries.push_back(end);
+        return boundaries;
+    }
+
+    /*
+        Parses the whole program like parse(), with the top-level functions
+        and procedures split into the chunks from findFunctionBoundaries() and
+        parsed on `threads` threads. Everything before the first function is
+        parsed here first, so each chunk starts with every type declared ahead
+        of it. A chunk gets its own Parser over a view of the tokens and its
+        own arena, and its elements are appended in source order. The chunks
+        intern their types into this parser's TypeRegistry, so a type is one
+        NodeType however many chunks use it, but whichever chunk gets to a
+        type first decides which occurrence of its name the node points at.
+        Interned nodes live in the chunk arenas, which are kept whether or
+        not the chunks are used.
+
+        Small programs and streamed tokens are parsed serially. So is the rest
+        of the program if any chunk fails or stops anywhere but the start of
+        the next one, then an error is reported at the right position.
+    */
+    NodeProgram* parseParallel(unsigned int threads = ThreadPool::defaultThreadCount()) {
+        if (threads <= 1 || !m_tokens.complete() || m_tokens.size() < PARALLEL_MIN_TOKENS) {
+            return parse();
+        }
+
+        LOG_DEBUG("================= Parser ===============");
+        parseTypealiases();
+
+        // the prefix declares the types every chunk may use
+        std::size_t first = findFirstFunction();
+        parseElements(first);
+
+        std::vector<std::size_t> boundaries;
+        if (m_pos == first) {
+            boundaries = findFunctionBoundaries(threads * 4);
+        }
+
+        if (boundaries.size() > 2) {
+            std::size_t chunk_count = boundaries.size() - 1;
+
+            struct Chunk {
+                std::unique_ptr<Parser> parser;
+                std::exception_ptr error;
+            };
+            std::vector<Chunk> chunks(chunk_count);
+
+            m_types->setShared(true);
+            ThreadPool pool(threads);
+            for (std::size_t i = 0; i < chunk_count; i++) {
+                Chunk& chunk = chunks[i];
+                chunk.parser.reset(new Parser(m_tokens.view(), m_types, m_lazy_bodies));
+                chunk.parser->m_pos = boundaries[i];
+
+                pool.submit([&chunk, end = boundaries[i + 1]] {
+                    try {
+                        chunk.parser->parseElements(end);
+                    } catch (...) {
+                        chunk.error = std::current_exception();
+                    }
+                });
+            }
+            pool.wait();
+            m_types->setShared(false);
+
+            bool parsed = true;
+            for (std::size_t i = 0; i < chunk_count; i++) {
+                parsed = parsed && !chunks[i].error && chunks[i].parser->m_pos == boundaries[i + 1];
+            }
+
+            // the registry may hold type nodes from any chunk
+            for (Chunk& chunk : chunks) {
+                m_chunk_arenas.push_back(std::move(chunk.parser->m_arena));
+            }
+
+            if (parsed) {
+                for (Chunk& chunk : chunks) {
+                    std::vector<NodeProgramElement*>& elements = chunk.parser->m_program->_elements;
+                    m_program->_elements.insert(m_program->_elements.end(), elements.begin(), elements.end());
+
+                    std::vector<std::pair<std::size_t, NodeFunctionDecleration*>>& lazy = chunk.parser->m_lazy_functions;
+                    m_lazy_functions.insert(m_lazy_functions.end(), lazy.begin(), lazy.end());
+                }
+                m_pos = boundaries.back();
+                m_parallel_chunks = chunk_count;
+                LOG_DEBUG("parsed " + std::to_string(chunk_count) + " chunks in parallel");
+            }
+        }
+
+        parseElements();
+        LOG_INFO("Program parsed");
+        return finishParse();
+    }
+
+    // how many chunks the last parseParallel() parsed in parallel, 0 if it parsed serially
+    std::size_t parallelChunks() const {
+        return m_parallel_chunks;
+    }
+
     void printTokens() {
-        std::cout << "tokens array size " << m_tokens.size() << std::endl;
-        for (auto it = m_tokens.begin(); it < m_tokens.end(); it++) {
-            std::cout << "::" << it->getStrValue() << std::endl;
+        for (std::size_t i = 0; m_tokens.at(i).getTokenType() != TokenType::_eof; i++) {
+            LOG_DEBUG("::" + std::string(m_tokens.at(i).getStrValue()));
         }
         return;
     }
 
     NodeProgram* parse() {
-        printDebug("================= Parser ===============");
-        printDebug(std::to_string(m_tokens.size()));
+        LOG_DEBUG("================= Parser ===============");
         // printTokens();
         parseProgram();
-        printProgram(m_program);
+        return finishParse();
+    }
+
+    /*
+        Off by default. When on, parse() and parseParallel() skip the bodies
+        of top-level functions and procedures, then parse only the ones
+        parseReachableBodies() reaches. The others keep a null body and are
+        left out of the generated code, parseBody() still parses one on request.
+    */
+    void setLazyBodies(bool lazy) {
+        m_lazy_bodies = lazy;
+    }
+
+    /*
+        parses the body of a function the lazy mode skipped and nothing
+        reached, nothing if it has been parsed already
+    */
+    void parseBody(NodeFunctionDecleration* node_function) {
+        if (node_function->_body_start == node_function->_body_end) {
+            return;
+        }
+
+        std::size_t resume = m_pos;
+        m_pos = node_function->_body_start;
+        parseFunctionBody(node_function);
+        node_function->_body_start = node_function->_body_end = 0;
+        m_pos = resume;
+    }
+
+    /*
+        Parses the skipped bodies reachable from the top-level statements.
+        A call is any function name followed by `(`, found by scanning the
+        tokens of the statements and then of each body as it is reached.
+        A struct or variable sharing a function's name reaches it too, which
+        parses a body too many but never misses one.
+    */
+    void parseReachableBodies() {
+        std::unordered_map<SymbolId, std::vector<NodeFunctionDecleration*>> functions;
+        for (auto& [start, node_function] : m_lazy_functions) {
+            functions[m_tokens.at(start + 1).getSymbol()].push_back(node_function);
+        }
+
+        std::vector<std::pair<std::size_t, std::size_t>> spans;
+        std::size_t next = 0;
+        for (auto& [start, node_function] : m_lazy_functions) {
+            spans.push_back({next, start});
+            next = node_function->_body_end;
+        }
+        spans.push_back({next, m_tokens.size() - 1});
+
+        while (!spans.empty()) {
+            auto [first, last] = spans.back();
+            spans.pop_back();
+
+            for (std::size_t i = first; i + 1 < last; i++) {
+                if (m_tokens.kind(i) != TokenType::_identifier || m_tokens.kind(i + 1) != TokenType::_open_paren) continue;
+
+                auto found = functions.find(m_tokens.at(i).getSymbol());
+                if (found == functions.end()) continue;
+
+                for (NodeFunctionDecleration* node_function : found->second) {
+                    if (node_function->_body_start == node_function->_body_end) continue;
+
+                    spans.push_back({node_function->_body_start, node_function->_body_end});
+                    parseBody(node_function);
+                }
+            }
+        }
+
+        m_lazy_functions.clear();
+    }
+
+    NodeProgram* finishParse() {
+        if (m_lazy_bodies) {
+            parseReachableBodies();
+        }
+        LOG_DEBUG(std::to_string(m_tokens.size()) + " tokens");
+
+        // the AST dump walks the whole tree, skip it unless it will be printed
+        if (logEnabled(LogLevel::debug)) {
+            printProgram(m_program);
+        }
         return m_program;
     }
 };
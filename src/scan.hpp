@@ -0,0 +1,200 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+    Byte scanners used by the tokenizer to get over runs of whitespace,
+    identifier characters, digits, comment bodies and string bodies many
+    bytes at a time.
+
+    On x86-64 the scanners compare a whole 32 byte (AVX2) or 16 byte (SSE2)
+    block per step, anything else falls back to the scalar loops below. The
+    scalar loops also finish the last partial block so the vector code never
+    reads past the end of the input.
+
+    Every scanner takes the input and a start offset and returns the offset
+    of the first byte that ends the run, or the size of the input if the run
+    reaches the end.
+*/
+namespace scan {
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool isStringSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n';
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX2__)
+using Block = __m256i;
+constexpr std::size_t BLOCK_SIZE = 32;
+constexpr uint32_t FULL_MASK = 0xffffffffu;
+
+inline Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Block splat(char c) { return _mm256_set1_epi8(c); }
+inline Block equal(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+inline Block greater(Block a, Block b) { return _mm256_cmpgt_epi8(a, b); }
+inline Block both(Block a, Block b) { return _mm256_and_si256(a, b); }
+inline Block either(Block a, Block b) { return _mm256_or_si256(a, b); }
+inline uint32_t mask(Block a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#else
+using Block = __m128i;
+constexpr std::size_t BLOCK_SIZE = 16;
+constexpr uint32_t FULL_MASK = 0xffffu;
+
+inline Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline Block splat(char c) { return _mm_set1_epi8(c); }
+inline Block equal(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+inline Block greater(Block a, Block b) { return _mm_cmpgt_epi8(a, b); }
+inline Block both(Block a, Block b) { return _mm_and_si128(a, b); }
+inline Block either(Block a, Block b) { return _mm_or_si128(a, b); }
+inline uint32_t mask(Block a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+#endif
+
+// bytes in [lo, hi], compares are signed so lo and hi must be ASCII
+inline Block inRange(Block a, char lo, char hi) {
+    return both(greater(a, splat(static_cast<char>(lo - 1))), greater(splat(static_cast<char>(hi + 1)), a));
+}
+
+/*
+    runs `block_mask` over whole blocks starting at `pos` until it reports a
+    set bit, returns the offset of that byte or the offset of the first
+    incomplete block
+*/
+template <typename BlockMask>
+inline std::size_t findBlock(std::string_view content, std::size_t pos, BlockMask block_mask, bool& found) {
+    found = false;
+    while (pos + BLOCK_SIZE <= content.size()) {
+        uint32_t bits = block_mask(load(content.data() + pos));
+        if (bits) {
+            found = true;
+            return pos + std::countr_zero(bits);
+        }
+        pos += BLOCK_SIZE;
+    }
+    return pos;
+}
+
+#endif
+
+template <typename Stop>
+inline std::size_t findScalar(std::string_view content, std::size_t pos, Stop stop) {
+    while (pos < content.size() && !stop(content[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// first byte that is not whitespace
+inline std::size_t skipWhitespace(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [](Block b) {
+        return ~mask(either(equal(b, splat(' ')), inRange(b, '\t', '\r'))) & FULL_MASK;
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, [](char c) { return !isWhitespace(c); });
+}
+
+// first byte that is not a letter, digit or `_`
+inline std::size_t identifierEnd(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [](Block b) {
+        Block word = either(either(inRange(b, 'a', 'z'), inRange(b, 'A', 'Z')), either(inRange(b, '0', '9'), equal(b, splat('_'))));
+        return ~mask(word) & FULL_MASK;
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, [](char c) { return !isIdentifierChar(c); });
+}
+
+// first byte that is not a decimal digit
+inline std::size_t digitEnd(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [](Block b) {
+        return ~mask(inRange(b, '0', '9')) & FULL_MASK;
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, [](char c) { return !isDigit(c); });
+}
+
+// first occurrence of `target`
+inline std::size_t findByte(std::string_view content, std::size_t pos, char target) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [target](Block b) {
+        return mask(equal(b, splat(target)));
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, [target](char c) { return c == target; });
+}
+
+// first `"`, `\` or newline, the bytes a string literal body has to stop at
+inline std::size_t stringBodyEnd(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [](Block b) {
+        return mask(either(either(equal(b, splat('"')), equal(b, splat('\\'))), equal(b, splat('\n'))));
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, isStringSpecial);
+}
+
+// first `"`, `'`, `/` or EOF byte, the bytes that can change whether the tokenizer is inside a literal or comment
+inline std::size_t stateChangeEnd(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    bool found;
+    pos = findBlock(content, pos, [](Block b) {
+        return mask(either(either(equal(b, splat('"')), equal(b, splat('\''))), either(equal(b, splat('/')), equal(b, splat(static_cast<char>(0xff))))));
+    }, found);
+    if (found) return pos;
+#endif
+    return findScalar(content, pos, [](char c) { return c == '"' || c == '\'' || c == '/' || c == static_cast<char>(0xff); });
+}
+
+// offset of the `*` of the first `*/`, or the size of the input if there is none
+inline std::size_t blockCommentEnd(std::string_view content, std::size_t pos) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    // compare each block against itself shifted by one byte, the shifted load needs one extra byte
+    while (pos + BLOCK_SIZE + 1 <= content.size()) {
+        const char* p = content.data() + pos;
+        uint32_t bits = mask(both(equal(load(p), splat('*')), equal(load(p + 1), splat('/'))));
+        if (bits) {
+            return pos + std::countr_zero(bits);
+        }
+        pos += BLOCK_SIZE;
+    }
+#endif
+    while (pos + 1 < content.size()) {
+        if (content[pos] == '*' && content[pos + 1] == '/') return pos;
+        pos++;
+    }
+    return content.size();
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    Read-only view of a source file.
+
+    Regular files are memory-mapped so the tokenizer reads straight from the
+    page cache without any copy. Pipes, character devices and stdin (path `-`)
+    cannot be mapped, those are read once into an owned buffer instead.
+*/
+class SourceFile {
+private:
+    std::string_view m_content;
+    void* m_mapping = nullptr;
+    std::size_t m_mapping_size = 0;
+    std::string m_buffer;
+
+public:
+    SourceFile() {}
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    ~SourceFile() {
+        if (m_mapping) {
+            munmap(m_mapping, m_mapping_size);
+        }
+    }
+
+    // returns false if the file could not be opened or read
+    bool open(const std::string& path) {
+        int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        bool ok = fstat(fd, &info) == 0;
+
+        if (ok && S_ISREG(info.st_mode) && info.st_size > 0) {
+            m_mapping_size = static_cast<std::size_t>(info.st_size);
+            m_mapping = mmap(nullptr, m_mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (m_mapping == MAP_FAILED) {
+                m_mapping = nullptr;
+                ok = readAll(fd, m_mapping_size);
+            } else {
+                madvise(m_mapping, m_mapping_size, MADV_SEQUENTIAL);
+                m_content = std::string_view(static_cast<const char*>(m_mapping), m_mapping_size);
+            }
+
+        } else if (ok) {
+            ok = readAll(fd, 0);
+        }
+
+        if (fd != STDIN_FILENO) {
+            close(fd);
+        }
+        return ok;
+    }
+
+    std::string_view content() const {
+        return m_content;
+    }
+
+private:
+    // fallback for anything that cannot be mapped, reads until EOF
+    bool readAll(int fd, std::size_t size_hint) {
+        m_buffer.resize(size_hint > 0 ? size_hint : 64 * 1024);
+        std::size_t size = 0;
+
+        while (true) {
+            if (size == m_buffer.size()) {
+                m_buffer.resize(m_buffer.size() * 2);
+            }
+
+            ssize_t count = read(fd, m_buffer.data() + size, m_buffer.size() - size);
+            if (count < 0) {
+                return false;
+            }
+            if (count == 0) {
+                break;
+            }
+            size += static_cast<std::size_t>(count);
+        }
+
+        m_buffer.resize(size);
+        m_content = m_buffer;
+        return true;
+    }
+};
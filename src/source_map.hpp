@@ -0,0 +1,106 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using SourceId = uint32_t;
+
+// the empty source, used by tokens that were not lexed from any buffer
+constexpr SourceId NO_SOURCE = 0;
+
+/*
+    Every source buffer the tokenizer has lexed, by SourceId.
+
+    Tokens only keep the id of their buffer and their offset in it, their
+    text is looked up here and their line and column are computed from the
+    offset when someone asks for them. The newline offsets of a buffer are
+    collected the first time a position in it is asked for, every later
+    lookup is a binary search.
+
+    Entries live in fixed blocks that are never moved, so looking up a
+    buffer does not lock. Ids fit in the 24 bits a Token has for them.
+*/
+class SourceMap {
+private:
+    struct Entry {
+        std::string_view content;
+        // offset of every `\n`, filled in on the first position() call
+        std::vector<uint32_t> newlines;
+        std::atomic<bool> indexed{false};
+    };
+
+    static constexpr std::size_t BLOCK_BITS = 10;
+    static constexpr std::size_t BLOCK_SIZE = std::size_t(1) << BLOCK_BITS;
+    static constexpr std::size_t MAX_SOURCES = std::size_t(1) << 24;
+
+    std::array<std::unique_ptr<Entry[]>, MAX_SOURCES / BLOCK_SIZE> m_blocks;
+    std::atomic<SourceId> m_size{0};
+    std::mutex m_mutex;
+
+    Entry& entry(SourceId id) const {
+        return m_blocks[id >> BLOCK_BITS][id & (BLOCK_SIZE - 1)];
+    }
+
+    SourceMap() {
+        add(std::string_view());
+    }
+
+public:
+    static SourceMap& global() {
+        static SourceMap map;
+        return map;
+    }
+
+    SourceId add(std::string_view content) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SourceId id = m_size.load(std::memory_order_relaxed);
+        if (id >= MAX_SOURCES) {
+            throw std::length_error("too many source buffers");
+        }
+
+        if (!m_blocks[id >> BLOCK_BITS]) {
+            m_blocks[id >> BLOCK_BITS] = std::make_unique<Entry[]>(BLOCK_SIZE);
+        }
+        entry(id).content = content;
+        m_size.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    // points `id` at the edited buffer `content`, tokens of `id` must all have been moved to it
+    void replace(SourceId id, std::string_view content) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry& source = entry(id);
+        source.content = content;
+        source.newlines.clear();
+        source.indexed.store(false, std::memory_order_release);
+    }
+
+    std::string_view content(SourceId id) const {
+        return entry(id).content;
+    }
+
+    // 0 based line and column of `offset`
+    std::pair<int, int> position(SourceId id, std::size_t offset) {
+        Entry& source = entry(id);
+        if (!source.indexed.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!source.indexed.load(std::memory_order_relaxed)) {
+                for (std::size_t i = source.content.find('\n'); i != std::string_view::npos; i = source.content.find('\n', i + 1)) {
+                    source.newlines.push_back(static_cast<uint32_t>(i));
+                }
+                source.indexed.store(true, std::memory_order_release);
+            }
+        }
+
+        std::size_t line = std::lower_bound(source.newlines.begin(), source.newlines.end(), offset) - source.newlines.begin();
+        std::size_t line_start = line == 0 ? 0 : source.newlines[line - 1] + 1;
+        return {static_cast<int>(line), static_cast<int>(offset - line_start)};
+    }
+};
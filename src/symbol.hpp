@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+using SymbolId = uint32_t;
+
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+/*
+    Interned identifier names.
+
+    The tokenizer interns every identifier it produces, so two tokens that
+    spell the same name carry the same dense SymbolId and later passes can
+    compare, hash or index by that integer instead of by the text.
+
+    Lookups go through an open addressed table of (hash, id) slots. Names
+    are copied into fixed size blocks that never move, so the views handed
+    out by name() stay valid for the life of the program.
+*/
+class SymbolTable {
+private:
+    struct Slot {
+        uint32_t hash;
+        SymbolId id;
+    };
+
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<Slot> m_slots = std::vector<Slot>(1024, Slot{0, NO_SYMBOL});
+    std::vector<std::string_view> m_names;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    std::size_t m_block_used = BLOCK_SIZE;
+
+    // FNV-1a
+    static uint32_t hash(std::string_view name) {
+        uint32_t h = 2166136261u;
+        for (char c : name) {
+            h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return h;
+    }
+
+    std::string_view store(std::string_view name) {
+        // a name larger than a block gets an allocation of its own, the current block keeps filling
+        if (name.size() > BLOCK_SIZE) {
+            auto position = m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1;
+            char* text = m_blocks.insert(position, std::make_unique<char[]>(name.size()))->get();
+            std::memcpy(text, name.data(), name.size());
+            return std::string_view(text, name.size());
+        }
+
+        if (name.size() > BLOCK_SIZE - m_block_used) {
+            m_blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            m_block_used = 0;
+        }
+
+        char* text = m_blocks.back().get() + m_block_used;
+        std::memcpy(text, name.data(), name.size());
+        m_block_used += name.size();
+        return std::string_view(text, name.size());
+    }
+
+    void grow() {
+        std::vector<Slot> slots(m_slots.size() * 2, Slot{0, NO_SYMBOL});
+        std::size_t mask = slots.size() - 1;
+
+        for (const Slot& slot : m_slots) {
+            if (slot.id == NO_SYMBOL) continue;
+
+            std::size_t i = slot.hash & mask;
+            while (slots[i].id != NO_SYMBOL) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+        m_slots = std::move(slots);
+    }
+
+public:
+    static SymbolTable& global() {
+        static SymbolTable table;
+        return table;
+    }
+
+    SymbolId intern(std::string_view name) {
+        uint32_t h = hash(name);
+        std::size_t mask = m_slots.size() - 1;
+
+        std::size_t i = h & mask;
+        while (m_slots[i].id != NO_SYMBOL) {
+            if (m_slots[i].hash == h && m_names[m_slots[i].id] == name) {
+                return m_slots[i].id;
+            }
+            i = (i + 1) & mask;
+        }
+
+        SymbolId id = static_cast<SymbolId>(m_names.size());
+        m_names.push_back(store(name));
+        m_slots[i] = Slot{h, id};
+
+        // keep the load factor under one half
+        if (m_names.size() * 2 > m_slots.size()) {
+            grow();
+        }
+        return id;
+    }
+
+    std::string_view name(SymbolId id) const {
+        return id < m_names.size() ? m_names[id] : std::string_view();
+    }
+
+    std::size_t size() const {
+        return m_names.size();
+    }
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Fixed size pool of worker threads. Jobs run in submission order as
+    workers free up, wait() blocks until every submitted job has finished.
+    Jobs must not throw, catch inside the job and hand the error back.
+*/
+class ThreadPool {
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_all_done;
+    std::size_t m_running = 0;
+    bool m_stopping = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_job_ready.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                if (m_jobs.empty()) return;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_running++;
+            }
+
+            job();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running--;
+            if (m_jobs.empty() && m_running == 0) {
+                m_all_done.notify_all();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(unsigned int threads) {
+        for (unsigned int i = 0; i < std::max(threads, 1u); i++) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_job_ready.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_job_ready.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_all_done.wait(lock, [this] { return m_jobs.empty() && m_running == 0; });
+    }
+
+    static unsigned int defaultThreadCount() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+};
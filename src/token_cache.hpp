@@ -0,0 +1,254 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "literal.hpp"
+#include "log.hpp"
+#include "source.hpp"
+#include "source_map.hpp"
+#include "symbol.hpp"
+#include "tokenization.hpp"
+
+#ifndef COMPILER_VERSION
+#define COMPILER_VERSION "0.1"
+#endif
+
+/*
+    On-disk token cache, the `.gaztok` file next to a source file.
+
+    A cache file holds every token of one source file so an unchanged file
+    can be parsed without running the Tokenizer at all. It is only valid for
+    the exact source content and compiler it was written by: the header
+    carries a hash of the content and a hash of COMPILER_VERSION and the
+    format, anything that does not match is treated as a miss.
+
+    Layout, native byte order:
+
+        Header
+        Record[token_count]
+        uint32_t symbol lengths[symbol_count]
+        uint32_t literal lengths[literal_count]
+        symbol names, then decoded literals, back to back
+
+    A record is a token's type, offset, length and value. The value of an
+    identifier or literal is its index in the file, on load the names and
+    literals are interned once and the indices mapped to the global ids.
+    Token text, lines and columns are not stored, they come from the source
+    like for freshly lexed tokens.
+*/
+class TokenCache {
+private:
+    static constexpr char MAGIC[8] = {'G', 'A', 'Z', 'T', 'O', 'K', '\0', '\0'};
+    static constexpr uint32_t FORMAT = 2;
+
+    struct Header {
+        char magic[8];
+        uint64_t version;
+        uint64_t source_hash;
+        uint64_t source_size;
+        uint64_t token_count;
+        uint32_t symbol_count;
+        uint32_t literal_count;
+    };
+
+    struct Record {
+        uint32_t offset;
+        uint32_t length;
+        // Token::getValue(), with symbols and literals as indices into the file's
+        uint32_t value;
+        uint8_t type;
+        uint8_t unused[3];
+    };
+
+    static_assert(sizeof(Header) % alignof(Record) == 0 && sizeof(Record) == 16);
+
+    std::string m_path;
+
+    static uint64_t version() {
+        std::string key = std::string(COMPILER_VERSION) + "/" + std::to_string(FORMAT) + "/" + std::to_string(static_cast<int>(TokenType::_eof));
+        return hash(key);
+    }
+
+    template <typename T>
+    static void append(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+public:
+    explicit TokenCache(std::string path) : m_path(std::move(path)) {}
+
+    // the cache file used for the source file at `source_path`
+    static std::string pathFor(const std::string& source_path) {
+        return source_path + ".gaztok";
+    }
+
+    // 64 bit FNV-1a over 8 byte words, with the tail folded in byte by byte
+    static uint64_t hash(std::string_view content) {
+        uint64_t h = 14695981039346656037ull;
+        std::size_t i = 0;
+        for (; i + 8 <= content.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, content.data() + i, 8);
+            h = (h ^ word) * 1099511628211ull;
+            h ^= h >> 32;
+        }
+        for (; i < content.size(); i++) {
+            h = (h ^ static_cast<unsigned char>(content[i])) * 1099511628211ull;
+        }
+        return h ^ content.size();
+    }
+
+    /*
+        Returns the tokens of `content` if the cache file exists and was
+        written for exactly this content and compiler, nothing otherwise.
+        Identifiers and literals are interned into the global tables.
+    */
+    std::optional<std::vector<Token>> load(std::string_view content) const {
+        SourceFile file;
+        if (!file.open(m_path)) return std::nullopt;
+
+        std::string_view data = file.content();
+        if (data.size() < sizeof(Header)) return std::nullopt;
+
+        Header header;
+        std::memcpy(&header, data.data(), sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != version() || header.source_size != content.size()) {
+            return std::nullopt;
+        }
+
+        if (header.token_count > data.size() / sizeof(Record)) return std::nullopt;
+
+        std::size_t strings = header.symbol_count + static_cast<std::size_t>(header.literal_count);
+        std::size_t body = sizeof(Header) + header.token_count * sizeof(Record) + strings * sizeof(uint32_t);
+        if (body > data.size()) return std::nullopt;
+
+        if (header.source_hash != hash(content)) return std::nullopt;
+
+        // names and literals back to back after the length arrays
+        const uint32_t* lengths = reinterpret_cast<const uint32_t*>(data.data() + sizeof(Header) + header.token_count * sizeof(Record));
+        std::vector<SymbolId> symbols(header.symbol_count);
+        std::vector<LiteralId> literals(header.literal_count);
+
+        std::size_t text = body;
+        for (std::size_t i = 0; i < strings; i++) {
+            if (lengths[i] > data.size() - text) return std::nullopt;
+            std::string_view value = data.substr(text, lengths[i]);
+            if (i < header.symbol_count) {
+                symbols[i] = SymbolTable::global().intern(value);
+            } else {
+                literals[i - header.symbol_count] = LiteralTable::global().intern(value);
+            }
+            text += lengths[i];
+        }
+
+        const Record* records = reinterpret_cast<const Record*>(data.data() + sizeof(Header));
+        SourceId source = SourceMap::global().add(content);
+        std::vector<Token> tokens(header.token_count);
+
+        for (std::size_t i = 0; i < header.token_count; i++) {
+            const Record& record = records[i];
+            if (record.type > static_cast<uint8_t>(TokenType::_eof) || record.offset > content.size() || record.length > content.size() - record.offset) {
+                return std::nullopt;
+            }
+
+            Token& token = tokens[i];
+            token = Token(static_cast<TokenType>(record.type), source, record.offset, record.length);
+            token.setValue(record.value);
+
+            if (token.getTokenType() == TokenType::_identifier) {
+                if (record.value >= symbols.size()) return std::nullopt;
+                token.setSymbol(symbols[record.value]);
+            } else if (token.isLiteral()) {
+                if (record.value >= literals.size()) return std::nullopt;
+                token.setLiteral(literals[record.value]);
+            }
+        }
+
+        LOG_INFO("Loaded " + std::to_string(tokens.size()) + " tokens from " + m_path);
+        return tokens;
+    }
+
+    /*
+        Writes the tokens of `content` to the cache file. The file is written
+        under a temporary name and renamed into place, so a concurrent reader
+        sees either the old cache or the complete new one.
+    */
+    bool save(std::string_view content, const std::vector<Token>& tokens) const {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = version();
+        header.source_hash = hash(content);
+        header.source_size = content.size();
+        header.token_count = tokens.size();
+
+        // global ids to indices in the file, in order of first use
+        std::vector<uint32_t> symbol_index(SymbolTable::global().size(), NO_SYMBOL);
+        std::vector<uint32_t> literal_index(LiteralTable::global().size(), NO_LITERAL);
+        std::vector<SymbolId> symbols;
+        std::vector<LiteralId> literals;
+
+        std::string out;
+        out.reserve(sizeof(Header) + tokens.size() * sizeof(Record));
+        append(out, header);
+
+        for (const Token& token : tokens) {
+            Record record{};
+            record.offset = static_cast<uint32_t>(token.getOffset());
+            record.length = static_cast<uint32_t>(token.getLength());
+            record.type = static_cast<uint8_t>(token.getTokenType());
+            record.value = token.getValue();
+
+            if (token.getSymbol() != NO_SYMBOL) {
+                uint32_t& index = symbol_index[token.getSymbol()];
+                if (index == NO_SYMBOL) {
+                    index = static_cast<uint32_t>(symbols.size());
+                    symbols.push_back(token.getSymbol());
+                }
+                record.value = index;
+            } else if (token.isLiteral()) {
+                uint32_t& index = literal_index[token.getLiteral()];
+                if (index == NO_LITERAL) {
+                    index = static_cast<uint32_t>(literals.size());
+                    literals.push_back(token.getLiteral());
+                }
+                record.value = index;
+            }
+            append(out, record);
+        }
+
+        for (SymbolId id : symbols) append(out, static_cast<uint32_t>(SymbolTable::global().name(id).size()));
+        for (LiteralId id : literals) append(out, static_cast<uint32_t>(LiteralTable::global().text(id).size()));
+        for (SymbolId id : symbols) out.append(SymbolTable::global().name(id));
+        for (LiteralId id : literals) out.append(LiteralTable::global().text(id));
+
+        // patch the counts into the header written above
+        header.symbol_count = static_cast<uint32_t>(symbols.size());
+        header.literal_count = static_cast<uint32_t>(literals.size());
+        std::memcpy(out.data(), &header, sizeof(Header));
+
+        std::string temp_path = m_path + "." + std::to_string(getpid()) + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(temp_path.c_str(), m_path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+
+        LOG_INFO("Wrote " + std::to_string(tokens.size()) + " tokens to " + m_path);
+        return true;
+    }
+};
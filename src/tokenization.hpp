@@ -1,16 +1,27 @@
 #pragma once
-#include <string>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "literal.hpp"
+#include "log.hpp"
+#include "scan.hpp"
+#include "source_map.hpp"
+#include "symbol.hpp"
+#include "thread_pool.hpp"
 
-#define CYAN    "\033[36m"
-#define GREEN   "\033[32m"
-#define YELLOW  "\033[33m"
-#define RED     "\033[31m"
-
-
-enum class TokenType {
+enum class TokenType : uint8_t {
     _and,
     _as,
     _boolean,
@@ -96,765 +107,1100 @@ enum class TokenType {
     _not_eq,
     _dbl_asterisk,
     _generator,
+    _eof,
+};
+
+/*
+    Keywords and punctuators, classified with a perfect hash.
+
+    keywordHash() only looks at the first character, the last character and the
+    length of a lexeme. The constants were picked so that every entry below lands
+    in its own slot of KEYWORD_TABLE; buildKeywordTable() refuses to compile if a
+    new entry ever collides, so a lookup is one hash, one load and one compare.
+
+    `+` and `-` are stored as their binary forms, getToken() decides whether they
+    are unary from the previous token.
+*/
+struct KeywordEntry {
+    std::string_view lexeme;
+    TokenType type;
+};
+
+constexpr KeywordEntry KEYWORDS[] = {
+    {"and", TokenType::_and},
+    {"->", TokenType::_stream_output},
+    {"<-", TokenType::_stream_input},
+    {"as", TokenType::_as},
+    {"boolean", TokenType::_boolean},
+    {"break", TokenType::_break},
+    {"by", TokenType::_by},
+    {"call", TokenType::_call},
+    {"character", TokenType::_character},
+    {"columns", TokenType::_columns},
+    {"const", TokenType::_const},
+    {"continue", TokenType::_continue},
+    {"else", TokenType::_else},
+    {"false", TokenType::_false},
+    {"format", TokenType::_format},
+    {"function", TokenType::_function},
+    {"if", TokenType::_if},
+    {"else if", TokenType::_else_if},
+    {"in", TokenType::_in},
+    {"integer", TokenType::_integer},
+    {"length", TokenType::_length},
+    {"loop", TokenType::_loop},
+    {"not", TokenType::_not},
+    {"or", TokenType::_or},
+    {"procedure", TokenType::_procedure},
+    {"real", TokenType::_real},
+    {"return", TokenType::_return},
+    {"returns", TokenType::_returns},
+    {"reverse", TokenType::_reverse},
+    {"rows", TokenType::_rows},
+    {"std_input", TokenType::_std_input},
+    {"std_output", TokenType::_std_output},
+    {"stream_state", TokenType::_stream_state},
+    {"string", TokenType::_string},
+    {"struct", TokenType::_struct},
+    {"true", TokenType::_true},
+    {"tuple", TokenType::_tuple},
+    {"typealias", TokenType::_typealias},
+    {"var", TokenType::_var},
+    {"vector", TokenType::_vector},
+    {"while", TokenType::_while},
+    {"xor", TokenType::_xor},
+
+    // custom
+    {";", TokenType::_semi},
+    {"^", TokenType::_hat},
+    {"{", TokenType::_open_curly},
+    {"}", TokenType::_close_curly},
+    {"(", TokenType::_open_paren},
+    {")", TokenType::_close_paren},
+    {"[", TokenType::_open_square},
+    {"]", TokenType::_close_square},
+    {"=", TokenType::_assign},
+    {">", TokenType::_greater_than},
+    {"<", TokenType::_less_than},
+    {"'", TokenType::_sgl_quote},
+    {"\"", TokenType::_dbl_quote},
+    {",", TokenType::_comma},
+    {".", TokenType::_period},
+    {"+", TokenType::_binary_plus},
+    {"-", TokenType::_binary_minus},
+    {"*", TokenType::_asterisk},
+    {"/", TokenType::_fwd_slash},
+    {"|", TokenType::_vert_line},
+    {"%", TokenType::_mod},
+    {"&", TokenType::_ampersand},
+
+    // double chars
+    {"==", TokenType::_check_equal},
+    {">=", TokenType::_greater_than_equal},
+    {"<=", TokenType::_less_than_equal},
+    {"..", TokenType::_dbl_period},
+    {"||", TokenType::_dbl_vertical_line},
+    {"!=", TokenType::_not_eq},
+    {"**", TokenType::_dbl_asterisk},
+};
+
+constexpr std::size_t KEYWORD_TABLE_SIZE = 256;
+
+constexpr std::size_t keywordHash(std::string_view lexeme) {
+    return (static_cast<unsigned char>(lexeme.front()) * 12u +
+            static_cast<unsigned char>(lexeme.back()) * 38u +
+            lexeme.size() * 27u) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+// slot -> index into KEYWORDS plus one, 0 marks an empty slot
+constexpr std::array<unsigned char, KEYWORD_TABLE_SIZE> buildKeywordTable() {
+    std::array<unsigned char, KEYWORD_TABLE_SIZE> table{};
+    for (std::size_t i = 0; i < std::size(KEYWORDS); i++) {
+        std::size_t slot = keywordHash(KEYWORDS[i].lexeme);
+        if (table[slot] != 0) {
+            throw "keywordHash() is not perfect for KEYWORDS, pick new constants";
+        }
+        table[slot] = static_cast<unsigned char>(i + 1);
+    }
+    return table;
+}
+
+constexpr std::array<unsigned char, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = buildKeywordTable();
+
+constexpr std::optional<TokenType> lookupKeyword(std::string_view lexeme) {
+    if (lexeme.empty()) return std::nullopt;
+
+    unsigned char entry = KEYWORD_TABLE[keywordHash(lexeme)];
+    if (entry != 0 && KEYWORDS[entry - 1].lexeme == lexeme) {
+        return KEYWORDS[entry - 1].type;
+    }
+    return std::nullopt;
+}
+
+static_assert(lookupKeyword("typealias") == TokenType::_typealias);
+static_assert(lookupKeyword("**") == TokenType::_dbl_asterisk);
+static_assert(!lookupKeyword("typealiases"));
+
+/*
+    Character classes for the tokenizer's dispatch, one load per byte.
+
+    CHAR_SPECIAL bytes end a word and start a punctuator or literal even
+    without whitespace in front of them. CHAR_END is the EOF byte, which stops
+    tokenizing like the end of the input does.
+*/
+enum CharClass : unsigned char {
+    CHAR_WORD,
+    CHAR_WHITESPACE,
+    CHAR_SPECIAL,
+    CHAR_END,
 };
 
+constexpr std::string_view SPECIAL_CHARS = ";{}()[]\"'=.,<>+-*/|%&^";
+
+constexpr std::array<CharClass, 256> buildCharClassTable() {
+    std::array<CharClass, 256> table{};
+    for (char c : std::string_view(" \t\n\v\f\r")) table[static_cast<unsigned char>(c)] = CHAR_WHITESPACE;
+    for (char c : SPECIAL_CHARS) table[static_cast<unsigned char>(c)] = CHAR_SPECIAL;
+    table[static_cast<unsigned char>(EOF)] = CHAR_END;
+    return table;
+}
+
+constexpr std::array<CharClass, 256> CHAR_CLASS_TABLE = buildCharClassTable();
+
+constexpr CharClass charClass(char c) {
+    return CHAR_CLASS_TABLE[static_cast<unsigned char>(c)];
+}
+
+/*
+    Two character punctuators. Row `first` of DOUBLE_CHAR_TABLE is a 128 bit
+    set of the characters that may follow `first`, so checking a pair is one
+    load and one bit test.
+*/
+constexpr std::string_view DOUBLE_CHARS[] = {
+    "->", "<-", "//", "/*", ">=", "<=", "<<", ">>", "..", "**", "!=", "||", "==",
+};
+
+constexpr std::array<std::array<uint64_t, 2>, 128> buildDoubleCharTable() {
+    std::array<std::array<uint64_t, 2>, 128> table{};
+    for (std::string_view pair : DOUBLE_CHARS) {
+        unsigned char next = static_cast<unsigned char>(pair[1]);
+        table[static_cast<unsigned char>(pair[0])][next / 64] |= uint64_t(1) << (next % 64);
+    }
+    return table;
+}
+
+constexpr std::array<std::array<uint64_t, 2>, 128> DOUBLE_CHAR_TABLE = buildDoubleCharTable();
+
+constexpr bool isDoubleCharPair(char c, char next) {
+    unsigned char first = static_cast<unsigned char>(c);
+    unsigned char second = static_cast<unsigned char>(next);
+    return first < 128 && second < 128 && ((DOUBLE_CHAR_TABLE[first][second / 64] >> (second % 64)) & 1);
+}
+
+static_assert(charClass('{') == CHAR_SPECIAL && charClass('!') == CHAR_WORD && charClass('\v') == CHAR_WHITESPACE);
+static_assert(isDoubleCharPair('<', '-') && isDoubleCharPair('/', '*') && !isDoubleCharPair('-', '<'));
+
+/*
+    A token is 16 bytes: its kind, the SourceMap entry of the buffer it was
+    lexed from, its span in that buffer and one 32-bit value whose meaning
+    depends on the kind:
+
+    * `_identifier`: the interned SymbolId
+    * `_text` and `_char_lit`: the LiteralId of the decoded literal
+    * `_int_lit`: the value, or WIDE_VALUE if it does not fit in 32 bits
+
+    Everything else is derived when asked for. The text is a view into the
+    source buffer, line and column come from the SourceMap, and reals and
+    wide integers are parsed again from their text. The tokenizer has
+    already checked that they parse, and the parser asks for each value
+    once.
+*/
 class Token {
 private:
-    TokenType m_type;
-    std::string m_str_value;
-    int m_line;
-    int m_char;
+    uint32_t m_type : 8;
+    uint32_t m_source : 24;
+    uint32_t m_offset;
+    uint32_t m_length;
+    uint32_t m_value;
 
 public:
-    Token() {}
+    static constexpr uint32_t WIDE_VALUE = UINT32_MAX;
+
+    Token() : m_type(0), m_source(NO_SOURCE), m_offset(0), m_length(0), m_value(0) {}
 
-    Token(TokenType type, std::string str_value, int line, int _char) {
-        m_type = type;
-        m_str_value = str_value;
-        m_line = line;
-        m_char = _char;
+    Token(TokenType type, SourceId source, std::size_t offset, std::size_t length) {
+        m_type = static_cast<uint32_t>(type);
+        m_source = source;
+        m_offset = static_cast<uint32_t>(offset);
+        m_length = static_cast<uint32_t>(length);
+        m_value = 0;
     }
 
-    int getLine() {
-        return m_line;
+    int getLine() const {
+        return SourceMap::global().position(m_source, m_offset).first;
     }
 
-    int getChar() {
-        return m_char;
+    int getChar() const {
+        return SourceMap::global().position(m_source, m_offset).second;
     }
 
-    std::vector<int> getPos() {
-        return std::vector<int>{getLine(), getChar()};
+    std::vector<int> getPos() const {
+        auto [line, _char] = SourceMap::global().position(m_source, m_offset);
+        return std::vector<int>{line, _char};
     }
 
-    TokenType getTokenType() {
-        return m_type;
+    TokenType getTokenType() const {
+        return static_cast<TokenType>(m_type);
     }
 
     void setTokenType(TokenType new_type) {
-        m_type = new_type;
+        m_type = static_cast<uint32_t>(new_type);
     }
 
-
-    std::string getStrValue() {
-        return m_str_value;
+    SourceId getSource() const {
+        return m_source;
     }
 
-};
-
-class Tokenizer {
-private:
-    std::vector<Token> m_tokens;
-    std::string m_content;
+    std::size_t getOffset() const {
+        return m_offset;
+    }
 
-public:
-    explicit Tokenizer(std::string content) {
-        m_content = content;
+    void setOffset(std::size_t offset) {
+        m_offset = static_cast<uint32_t>(offset);
     }
 
-    void printDebug(std::string msg) {
-        std::cout << std::string(CYAN) + "[debug] " + msg + "\033[0m" << std::endl;
+    std::size_t getLength() const {
+        return m_length;
     }
 
-    void printOk(std::string msg) {
-        std::cout << std::string(GREEN) + "[ok] " + msg + "\033[0m" << std::endl;
+    bool isLiteral() const {
+        return getTokenType() == TokenType::_text || getTokenType() == TokenType::_char_lit;
     }
 
-    void printError(std::string error_msg) {
-        throw std::runtime_error(std::string(RED) + error_msg + "\033[0m");
+    // the lexeme, or the decoded text of a string/character literal
+    std::string_view getStrValue() const {
+        if (isLiteral()) {
+            return LiteralTable::global().text(m_value);
+        }
+        return SourceMap::global().content(m_source).substr(m_offset, m_length);
     }
 
-    void printError(std::string error_msg, int line, int _char) {
-        throw std::runtime_error(std::string(RED) + error_msg + " at " + std::to_string(line) + ":" + std::to_string(_char) + "\033[0m");
+    // the kind dependent 32-bit value, as stored
+    uint32_t getValue() const {
+        return m_value;
     }
 
-    bool isOperator(Token token) {
-        // checks if token is an operator
-        return token.getTokenType() == TokenType::_period || 
-            token.getTokenType() == TokenType::_dbl_period || 
-            token.getTokenType() == TokenType::_binary_plus || 
-            token.getTokenType() == TokenType::_unary_plus || 
-            token.getTokenType() == TokenType::_binary_minus || 
-            token.getTokenType() == TokenType::_unary_minus || 
-            token.getTokenType() == TokenType::_not || 
-            token.getTokenType() == TokenType::_hat || 
-            token.getTokenType() == TokenType::_asterisk || 
-            token.getTokenType() == TokenType::_fwd_slash || 
-            token.getTokenType() == TokenType::_mod || 
-            token.getTokenType() == TokenType::_dbl_asterisk || 
-            token.getTokenType() == TokenType::_by || 
-            token.getTokenType() == TokenType::_greater_than || 
-            token.getTokenType() == TokenType::_less_than || 
-            token.getTokenType() == TokenType::_greater_than_equal || 
-            token.getTokenType() == TokenType::_less_than_equal || 
-            token.getTokenType() == TokenType::_check_equal || 
-            token.getTokenType() == TokenType::_not_eq || 
-            token.getTokenType() == TokenType::_and || 
-            token.getTokenType() == TokenType::_or || 
-            token.getTokenType() == TokenType::_xor || 
-            token.getTokenType() == TokenType::_dbl_vertical_line;
-    }
-
-    Token getToken(std::string content, int line, int _char) {
-        // adjust the marker to point before the token
-        _char -= content.length();
-
-        if (content.starts_with("//")) {
-            return Token(TokenType::_comment, content, line, _char);
-        }
-
-        else if (content.starts_with("/*")) {
-            if (content.ends_with("*/"))
-                return Token(TokenType::_comment, content, line, _char);
-            else {
-                printError("Expected `*/`", line, _char);
-                exit(1);
-            }
+    void setValue(uint32_t value) {
+        m_value = value;
+    }
 
+    int64_t getIntValue() const {
+        if (m_value != WIDE_VALUE) {
+            return m_value;
         }
 
-        else if (content == "and") {
-            return Token(TokenType::_and, "`and`", line, _char);
-        }
+        std::string_view text = getStrValue();
+        int64_t value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
 
-        else if (content == "->") {
-            return Token(TokenType::_stream_output, "`->`", line, _char);
-        }
+    double getRealValue() const {
+        std::string_view text = getStrValue();
+        double value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
 
-        else if (content == "<-") {
-            return Token(TokenType::_stream_input, "`<-`", line, _char);
-        }
+    LiteralId getLiteral() const {
+        return isLiteral() ? m_value : NO_LITERAL;
+    }
 
-        else if (content == "as") {
-            return Token(TokenType::_as, "`as`", line, _char);
-        }
+    void setLiteral(LiteralId literal) {
+        m_value = literal;
+    }
 
-        else if (content == "boolean") {
-            return Token(TokenType::_boolean, "`boolean`", line, _char);
-        }
+    SymbolId getSymbol() const {
+        return getTokenType() == TokenType::_identifier ? m_value : NO_SYMBOL;
+    }
 
-        else if (content == "break") {
-            return Token(TokenType::_break, "`break`", line, _char);
-        }
+    void setSymbol(SymbolId symbol) {
+        m_value = symbol;
+    }
 
-        else if (content == "by") {
-            return Token(TokenType::_by, "`by`", line, _char);
-        }
+};
 
-        else if (content == "call") {
-            return Token(TokenType::_call, "`call`", line, _char);
-        }
+static_assert(sizeof(Token) == 16);
 
-        else if (content == "character") {
-            return Token(TokenType::_character, "`character`", line, _char);
-        }
+// `removed` bytes at `offset` replaced by `inserted`
+struct TextEdit {
+    std::size_t offset;
+    std::size_t removed;
+    std::string_view inserted;
+};
 
-        else if (content == "columns") {
-            return Token(TokenType::_columns, "`columns`", line, _char);
-        }
+/*
+    Tokens do not own their text. The Tokenizer registers m_content with
+    the SourceMap and tokens find their text and position through it, so the
+    source buffer has to outlive the tokens. Decoded literals are interned
+    into the global LiteralTable and carry their LiteralId.
 
-        else if (content == "const") {
-            return Token(TokenType::_const, "`const`", line, _char);
-        }
+    Tokens are produced on demand: next() and peek(k) lex just far enough to
+    fill a LOOKAHEAD sized ring buffer, tokenize() drains the whole input.
+*/
+class Tokenizer {
+public:
+    static constexpr std::size_t LOOKAHEAD = 4;
 
-        else if (content == "continue") {
-            return Token(TokenType::_continue, "`continue`", line, _char);
-        }
+private:
+    std::string_view m_content;
+    // decoded text of the literal being lexed, reused so literals do not allocate
+    std::string m_literal_buffer;
+
+    // lexed but not yet consumed tokens
+    std::array<Token, LOOKAHEAD> m_lookahead;
+    std::size_t m_lookahead_start = 0;
+    std::size_t m_lookahead_count = 0;
+
+    // the most recently lexed token, decides whether `+` and `-` are unary
+    std::optional<TokenType> m_previous;
+
+    std::size_t m_pos = 0;
+
+    // the SourceMap entry tokens point into, chunks of a parallel run share their parent's
+    SourceId m_source = NO_SOURCE;
+
+    // where identifiers are interned, chunks of a parallel run use their own table
+    SymbolTable* m_symbols = &SymbolTable::global();
+    LiteralTable* m_literals = &LiteralTable::global();
+
+    // lexes content[begin, end) as one chunk of a parallel run, `begin` has to start a line
+    Tokenizer(std::string_view content, std::size_t begin, std::size_t end, SourceId source, SymbolTable& symbols, LiteralTable& literals) {
+        m_content = content.substr(0, end);
+        m_pos = begin;
+        m_source = source;
+        m_symbols = &symbols;
+        m_literals = &literals;
+    }
 
-        else if (content == "else") {
-            return Token(TokenType::_else, "`else`", line, _char);
-        }
+public:
+    // inputs smaller than this are not worth splitting
+    static constexpr std::size_t PARALLEL_MIN_SIZE = 1 << 20;
 
-        else if (content == "false") {
-            return Token(TokenType::_false, "`false`", line, _char);
-        }
+    explicit Tokenizer(std::string_view content) {
+        m_content = content;
+        m_source = SourceMap::global().add(content);
+    }
 
-        else if (content == "format") {
-            return Token(TokenType::_format, "`format`", line, _char);
-        }
+    void printError(std::string error_msg) {
+        throw std::runtime_error(std::string(RED) + error_msg + "\033[0m");
+    }
 
-        else if (content == "function") {
-            return Token(TokenType::_function, "`function`", line, _char);
-        }
+    // reports an error at `offset`, the line and column are only counted out here
+    void printError(std::string error_msg, std::size_t offset) {
+        std::string_view before = m_content.substr(0, offset);
+        std::size_t line = std::count(before.begin(), before.end(), '\n');
+        std::size_t line_start = before.rfind('\n') == std::string_view::npos ? 0 : before.rfind('\n') + 1;
+        throw std::runtime_error(std::string(RED) + error_msg + " at " + std::to_string(line) + ":" + std::to_string(offset - line_start) + "\033[0m");
+    }
 
-        else if (content == "if") {
-            return Token(TokenType::_if, "`if`", line, _char);
-        }
+    static bool isOperator(TokenType token_type) {
+        // checks if token is an operator
+        return token_type == TokenType::_period || 
+            token_type == TokenType::_dbl_period || 
+            token_type == TokenType::_binary_plus || 
+            token_type == TokenType::_unary_plus || 
+            token_type == TokenType::_binary_minus || 
+            token_type == TokenType::_unary_minus || 
+            token_type == TokenType::_not || 
+            token_type == TokenType::_hat || 
+            token_type == TokenType::_asterisk || 
+            token_type == TokenType::_fwd_slash || 
+            token_type == TokenType::_mod || 
+            token_type == TokenType::_dbl_asterisk || 
+            token_type == TokenType::_by || 
+            token_type == TokenType::_greater_than || 
+            token_type == TokenType::_less_than || 
+            token_type == TokenType::_greater_than_equal || 
+            token_type == TokenType::_less_than_equal || 
+            token_type == TokenType::_check_equal || 
+            token_type == TokenType::_not_eq || 
+            token_type == TokenType::_and || 
+            token_type == TokenType::_or || 
+            token_type == TokenType::_xor || 
+            token_type == TokenType::_dbl_vertical_line;
+    }
 
-        else if (content == "else if") {
-            return Token(TokenType::_else_if, "`else if`", line, _char);
-        }
+    // whether `+` or `-` right after a token of type `previous` is unary, nullopt is the start of the input
+    static bool isUnaryAfter(std::optional<TokenType> previous) {
+        return !previous || isOperator(*previous) || 
+            *previous == TokenType::_open_curly || *previous == TokenType::_assign || *previous == TokenType::_open_paren || *previous == TokenType::_open_square || *previous == TokenType::_return;
+    }
 
-        else if (content == "in") {
-            return Token(TokenType::_in, "`in`", line, _char);
-        }
+    bool isUnaryPosition() {
+        return isUnaryAfter(m_previous);
+    }
 
-        else if (content == "integer") {
-            return Token(TokenType::_integer, "`integer`", line, _char);
-        }
+    // classifies the lexeme content[offset, offset + length)
+    Token getToken(std::size_t offset, std::size_t length) {
+        std::string_view content = m_content.substr(offset, length);
 
-        else if (content == "length") {
-            return Token(TokenType::_length, "`length`", line, _char);
-        }
+        // keywords and punctuators
+        if (std::optional<TokenType> keyword = lookupKeyword(content)) {
+            TokenType token_type = *keyword;
 
-        else if (content == "loop") {
-            return Token(TokenType::_loop, "`loop`", line, _char);
-        }
+            // `+` and `-` are unary unless they follow something that can end an operand
+            if ((token_type == TokenType::_binary_plus || token_type == TokenType::_binary_minus) && isUnaryPosition()) {
+                token_type = token_type == TokenType::_binary_plus ? TokenType::_unary_plus : TokenType::_unary_minus;
+            }
 
-        else if (content == "not") {
-            printDebug("found not");
-            return Token(TokenType::_not, "`not`", line, _char);
+            return Token(token_type, m_source, offset, length);
         }
 
-        else if (content == "or") {
-            return Token(TokenType::_or, "`or`", line, _char);
+        // integers become `_int_lit` with a 64-bit value, anything with a `.` a `_number` with a double
+        else if (isInt(content)) {
+            Token token(TokenType::_int_lit, m_source, offset, length);
+            int64_t value = 0;
+            if (std::from_chars(content.data(), content.data() + content.size(), value).ec != std::errc()) {
+                printError("Integer literal out of range", offset);
+            }
+            token.setValue(value < Token::WIDE_VALUE ? static_cast<uint32_t>(value) : Token::WIDE_VALUE);
+            return token;
         }
 
-        else if (content == "procedure") {
-            return Token(TokenType::_procedure, "`procedure`", line, _char);
+        else if (isNumber(content)) {
+            double value = 0;
+            if (std::from_chars(content.data(), content.data() + content.size(), value).ec != std::errc()) {
+                printError("Invalid real literal", offset);
+            }
+            return Token(TokenType::_number, m_source, offset, length);
         }
 
-        else if (content == "real") {
-            return Token(TokenType::_real, "`real`", line, _char);
+        else if (isIdentifier(content)) {
+            Token token(TokenType::_identifier, m_source, offset, length);
+            token.setSymbol(m_symbols->intern(content));
+            return token;
         }
 
-        else if (content == "return") {
-            return Token(TokenType::_return, "`return`", line, _char);
-        }
+        printError("Unexpected token", offset);
+        exit(EXIT_FAILURE);
+    }
 
-        else if (content == "returns") {
-            return Token(TokenType::_returns, "`returns`", line, _char);
-        }
 
-        else if (content == "reverse") {
-            return Token(TokenType::_reverse, "`reverse`", line, _char);
-        }
+    /*
+        returns 1 if buffer meets the criteria to be an identifier otherwise 0
+    */
+    bool isIdentifier(std::string_view content) {
+        LOG_TRACE("checking if identifier: " + std::string(content));
 
-        else if (content == "rows") {
-            return Token(TokenType::_rows, "`rows`", line, _char);
-        }
+        if (std::isalpha(*content.begin()) || *content.begin() == '_') {
+            for (auto s = content.begin() + 1; s < content.end(); s++) {
+                if (!std::isalnum(*s) && *s != '_') {
+                    return false;
+                }
+            }
 
-        else if (content == "std_input") {
-            return Token(TokenType::_std_input, "`std_input`", line, _char);
+            return true;
         }
 
-        else if (content == "std_output") {
-            return Token(TokenType::_std_output, "`std_output`", line, _char);
-        }
+        return false;
+    }
 
-        else if (content == "stream_state") {
-            return Token(TokenType::_stream_state, "`stream_state`", line, _char);
+    bool isInt(std::string_view content) {
+        LOG_TRACE("checking is int");
+        for (auto s = content.begin(); s < content.end(); s++) {
+            if (!std::isdigit(*s)) return false;
         }
+        return true;
+    }
 
-        else if (content == "string") {
-            return Token(TokenType::_string, "`string`", line, _char);
+    bool isRange(std::string_view content) {
+        LOG_TRACE("checking is generator");
+        bool found_1 = false;
+        bool found_2 = false;
+        for (auto s = content.begin(); s < content.end(); s++) {
+            if ((!std::isdigit(*s) && *s != '.') || (*s == '.' && found_1 && found_2)) return false;
+            
+            if (*s == '.' && found_1) found_2 = true;
+            else if (*s == '.') found_1 = true;
+            LOG_TRACE(std::string(1, *s) + " " + std::to_string(found_1) + " " + std::to_string(found_2));
         }
+        LOG_TRACE(std::to_string(found_1 && found_2));
+        return found_1 && found_2;
+    }
 
-        else if (content == "struct") {
-            return Token(TokenType::_struct, "`struct`", line, _char);
+    bool isNumber(std::string_view content) {
+        bool decimal = false;
+        for (auto s = content.begin(); s < content.end(); s++) {
+            if (*s == '.' && !decimal) decimal = true;
+            else if (!std::isdigit(*s)) return false;
         }
+        return true;
+    }
 
-        else if (content == "true") {
-            return Token(TokenType::_true, "`true`", line, _char);
-        }
+    // characters that end a word and are lexed on their own
+    bool isSpecial(char c) {
+        return charClass(c) == CHAR_SPECIAL;
+    }
 
-        else if (content == "tuple") {
-            return Token(TokenType::_tuple, "`tuple`", line, _char);
-        }
+    bool isDoubleChar(char c, char next) {
+        return isDoubleCharPair(c, next);
+    }
 
-        else if (content == "typealias") {
-            return Token(TokenType::_typealias, "`typealias`", line, _char);
-        }
+    // lexes an identifier, keyword or number starting at `start`
+    Token lexWord(std::size_t start) {
+        std::size_t end = scan::identifierEnd(m_content, start);
+        while (end < m_content.size()) {
+            CharClass char_class = charClass(m_content[end]);
+            if (char_class == CHAR_WHITESPACE || char_class == CHAR_END) break;
 
-        else if (content == "var") {
-            return Token(TokenType::_var, "`var`", line, _char);
-        }
+            if (char_class == CHAR_SPECIAL) {
+                // a single `.` continues a number, `..` after a number is a range
+                std::string_view word = m_content.substr(start, end - start);
+                bool is_decimal_point = m_content[end] == '.' && isNumber(word) && word.find('.') == std::string_view::npos &&
+                    !(end + 1 < m_content.size() && m_content[end + 1] == '.');
 
-        else if (content == "vector") {
-            return Token(TokenType::_vector, "`vector`", line, _char);
-        }
+                if (!is_decimal_point) break;
 
-        else if (content == "while") {
-            return Token(TokenType::_while, "`while`", line, _char);
+                end = scan::digitEnd(m_content, end + 1);
+                continue;
+            }
+            end++;
         }
 
-        else if (content == "xor") {
-            return Token(TokenType::_xor, "`xor`", line, _char);
-        }
+        m_pos = end;
+        return getToken(start, end - start);
+    }
 
-        // custom
-        else if (content == ";") {
-            return Token(TokenType::_semi, "`;`", line, _char);
-        }
+    bool isComment(std::size_t start) {
+        return m_content[start] == '/' && start + 1 < m_content.size() && (m_content[start + 1] == '/' || m_content[start + 1] == '*');
+    }
 
-        else if (content == "^") {
-            return Token(TokenType::_hat, "`^`", line, _char);
+    // skips a `//` or `/* */` comment starting at `start`, returns the offset after it
+    std::size_t skipComment(std::size_t start) {
+        if (m_content[start + 1] == '/') {
+            return scan::findByte(m_content, start, '\n');
         }
 
-        else if (content == "{") {
-            return Token(TokenType::_open_curly, "`{`", line, _char);
+        std::size_t end = scan::blockCommentEnd(m_content, start + 2);
+        if (end == m_content.size()) {
+            printError("Expected `*/`", start);
         }
 
-        else if (content == "}") {
-            return Token(TokenType::_close_curly, "`}`", line, _char);
-        }
+        return end + 2;
+    }
 
-        else if (content == "(") {
-            return Token(TokenType::_open_paren, "`(`", line, _char);
+    // appends what the escape whose `\` is at `it` stands for to m_literal_buffer, returns the offset after it
+    std::size_t decodeEscapeAt(std::size_t it) {
+        if (std::optional<char> decoded = decodeEscape(m_content[it + 1])) {
+            m_literal_buffer += *decoded;
         }
+        return it + 2;
+    }
 
-        else if (content == ")") {
-            return Token(TokenType::_close_paren, "`)`", line, _char);
-        }
+    Token literalToken(TokenType type, std::string_view text, std::size_t start, std::size_t end) {
+        Token token(type, m_source, start, end - start);
+        token.setLiteral(m_literals->intern(text));
+        return token;
+    }
 
-        else if (content == "[") {
-            return Token(TokenType::_open_square, "`[`", line, _char);
-        }
+    // lexes a string literal whose opening `"` is at `start`
+    Token lexString(std::size_t start) {
+        // without escapes or newlines the decoded text is the source text
+        std::size_t it = scan::stringBodyEnd(m_content, start + 1);
+        if (it < m_content.size() && m_content[it] == '"') {
+            m_pos = it + 1;
+            return literalToken(TokenType::_text, m_content.substr(start + 1, it - start - 1), start, it + 1);
+        }
+
+        m_literal_buffer.assign(m_content.substr(start + 1, it - start - 1));
+        while (it < m_content.size() && m_content[it] != '"') {
+            if (m_content[it] == '\\' && it + 1 < m_content.size()) {
+                it = decodeEscapeAt(it);
+            } else {
+                m_literal_buffer += m_content[it];
+                it++;
+            }
 
-        else if (content == "]") {
-            return Token(TokenType::_close_square, "`]`", line, _char);
+            // copy everything up to the next quote, escape or newline in one go
+            std::size_t run_end = scan::stringBodyEnd(m_content, it);
+            m_literal_buffer.append(m_content.substr(it, run_end - it));
+            it = run_end;
         }
 
-        else if (content == "=") {
-            return Token(TokenType::_assign, "`=`", line, _char);
+        if (it >= m_content.size()) {
+            printError("Expected `\"`", start);
         }
 
-        else if (content == ">") {
-            return Token(TokenType::_greater_than, "`>`", line, _char);
-        }
+        m_pos = it + 1;
+        return literalToken(TokenType::_text, m_literal_buffer, start, it + 1);
+    }
 
-        else if (content == "<") {
-            return Token(TokenType::_less_than, "`<`", line, _char);
-        }
+    // lexes a character literal whose opening `'` is at `start`
+    Token lexCharacter(std::size_t start) {
+        m_literal_buffer.clear();
 
-        else if (content == "'") {
-            return Token(TokenType::_sgl_quote, "`'`", line, _char);
+        std::size_t it = start + 1;
+        if (it < m_content.size() && m_content[it] == '\\' && it + 1 < m_content.size()) {
+            it = decodeEscapeAt(it);
+        } else if (it < m_content.size()) {
+            m_literal_buffer += m_content[it];
+            it++;
         }
 
-        else if (content == "\"") {
-            return Token(TokenType::_dbl_quote, "`\"`", line, _char);
+        if (it >= m_content.size() || m_content[it] != '\'') {
+            printError("Expected `'`", start);
         }
 
-        else if (content == ",") {
-            return Token(TokenType::_comma, "`,`", line, _char);
-        }
+        m_pos = it + 1;
+        return literalToken(TokenType::_char_lit, m_literal_buffer, start, it + 1);
+    }
 
-        else if (content == ".") {
-            return Token(TokenType::_period, "`.`", line, _char);
-        }
+    // lexes a punctuator or literal starting with a special character
+    Token lexSpecial(std::size_t start) {
+        char c = m_content[start];
+        std::size_t length = 1;
 
-        else if (content == "+") {
-            if (m_tokens.size() == 0 || isOperator(m_tokens.back()) || 
-                m_tokens.back().getTokenType() == TokenType::_open_curly || m_tokens.back().getTokenType() == TokenType::_assign || m_tokens.back().getTokenType() == TokenType::_open_paren || m_tokens.back().getTokenType() == TokenType::_open_square || m_tokens.back().getTokenType() == TokenType::_return
-            ) {
-                printDebug("Found _unary_plus");
-                return Token(TokenType::_unary_plus, "`+`", line, _char);
-            }
-            return Token(TokenType::_binary_plus, "`+`", line, _char);
+        if (start + 1 < m_content.size() && isDoubleChar(c, m_content[start + 1])) {
+            length = 2;
         }
 
-        else if (content == "-") {
-            if (m_tokens.size() == 0 || isOperator(m_tokens.back()) || 
-                m_tokens.back().getTokenType() == TokenType::_open_curly || m_tokens.back().getTokenType() == TokenType::_assign || m_tokens.back().getTokenType() == TokenType::_open_paren || m_tokens.back().getTokenType() == TokenType::_open_square || m_tokens.back().getTokenType() == TokenType::_return
-            ) {
-                printDebug("Found _unary_minus");
-                return Token(TokenType::_unary_minus, "`-`", line, _char);
-            }
-
-            return Token(TokenType::_binary_minus, "`-`", line, _char);
+        // handle strings and characters
+        if (c == '"') {
+            return lexString(start);
+        } else if (c == '\'') {
+            return lexCharacter(start);
         }
 
-        else if (content == "*") {
-            return Token(TokenType::_asterisk, "`*`", line, _char);
-        }
+        m_pos = start + length;
+        return getToken(start, length);
+    }
 
-        else if (content == "/") {
-            return Token(TokenType::_fwd_slash, "`/`", line, _char);
-        }
+    // lexes the token after m_pos into `token`, returns false once the input is exhausted
+    bool lexToken(Token& token) {
+        while (m_pos < m_content.size()) {
+            switch (charClass(m_content[m_pos])) {
+                case CHAR_END:
+                    m_pos = m_content.size();
+                    return false;
 
-        else if (content == "|") {
-            return Token(TokenType::_vert_line, "`|`", line, _char);
-        }
+                case CHAR_WHITESPACE:
+                    m_pos = scan::skipWhitespace(m_content, m_pos);
+                    break;
 
-        else if (content == "%") {
-            return Token(TokenType::_mod, "`%`", line, _char);
-        }
+                // handle single unique characters that may not have a space before them
+                case CHAR_SPECIAL:
+                    if (isComment(m_pos)) {
+                        m_pos = skipComment(m_pos);
+                        break;
+                    }
 
-        else if (content == "&") {
-            return Token(TokenType::_ampersand, "`&`", line, _char);
-        }
+                    token = lexSpecial(m_pos);
+                    return true;
 
-        // double chars
-        else if (content == "==") {
-            return Token(TokenType::_check_equal, "`==`", line, _char);
+                case CHAR_WORD:
+                    token = lexWord(m_pos);
+                    return true;
+            }
         }
 
-        else if (content == ">=") {
-            return Token(TokenType::_greater_than_equal, "`>=`", line, _char);
-        }
+        return false;
+    }
 
-        else if (content == "<=") {
-            return Token(TokenType::_less_than_equal, "`<=`", line, _char);
+    // lexes one more token, past the end of the input this is always `_eof`
+    Token lexNext() {
+        Token token;
+        if (!lexToken(token)) {
+            return Token(TokenType::_eof, m_source, m_content.size(), 0);
         }
 
-        else if (content == "..") {
-            return Token(TokenType::_dbl_period, "`..`", line, _char);
-        }
+        m_previous = token.getTokenType();
+        return token;
+    }
 
-        else if (content == "||") {
-            return Token(TokenType::_dbl_vertical_line, "`||`", line, _char);
-        }
+    // returns the token `k` positions ahead without consuming it, `k` must be below LOOKAHEAD
+    const Token& peek(std::size_t k = 0) {
+        assert(k < LOOKAHEAD);
 
-        else if (content == "!=") {
-            return Token(TokenType::_not_eq, "`!=`", line, _char);
+        while (m_lookahead_count <= k) {
+            m_lookahead[(m_lookahead_start + m_lookahead_count) % LOOKAHEAD] = lexNext();
+            m_lookahead_count++;
         }
 
-        else if (content == "**") {
-            return Token(TokenType::_dbl_asterisk, "`**`", line, _char);
-        }
+        return m_lookahead[(m_lookahead_start + k) % LOOKAHEAD];
+    }
 
-        
-        else if (isNumber(content)) {
-            printDebug("Found number");
-            return Token(TokenType::_number, content, line, _char);
-        }
-        
-        else if (isInt(content)) {
-            return Token(TokenType::_int_lit, content, line, _char);
-        }
+    // consumes and returns the next token
+    Token next() {
+        Token token = peek();
+        m_lookahead_start = (m_lookahead_start + 1) % LOOKAHEAD;
+        m_lookahead_count--;
+        return token;
+    }
 
-        else if (isIdentifier(content)) {
-            return Token(TokenType::_identifier, content, line, _char);
-        
+    // the returned vector is the only copy of the tokens, move it on rather than copying it
+    std::vector<Token> tokenize() {
+        std::vector<Token> tokens;
+        for (Token token = next(); token.getTokenType() != TokenType::_eof; token = next()) {
+            tokens.push_back(token);
         }
 
-        printError("Unexpected token", line, _char);
-        exit(EXIT_FAILURE);
-        return Token(TokenType::_text, "`text`: \"" + content + "\"", line, _char);
+        return tokens;
     }
 
-
     /*
-        returns 1 if buffer meets the criteria to be an identifier otherwise 0
+        Pre-pass for tokenizeParallel(). Tracks only whether the input is
+        inside a string, character literal or comment, and returns the start
+        offsets of about `count` equally sized chunks, each right after a
+        newline outside all of them. The last entry is where tokenizing stops:
+        the end of the input or an EOF byte.
+
+        Malformed literals or comments end the splitting, everything after
+        them stays in the last chunk where the lexer reports the error.
     */
-    bool isIdentifier(std::string content) {
-        printDebug("checking if identifier: " + content);
+    std::vector<std::size_t> findChunkBoundaries(std::size_t count) {
+        std::vector<std::size_t> boundaries{0};
+        std::size_t chunk_size = m_content.size() / std::max(count, std::size_t(1)) + 1;
+        std::size_t next_split = chunk_size;
+
+        std::size_t pos = 0;
+        while (pos < m_content.size()) {
+            std::size_t change = scan::stateChangeEnd(m_content, pos);
+
+            // every newline before `change` is outside literals and comments
+            std::string_view code = m_content.substr(0, change);
+            while (next_split < change) {
+                std::size_t newline = scan::findByte(code, std::max(pos, next_split), '\n');
+                if (newline >= change) break;
+
+                boundaries.push_back(newline + 1);
+                next_split = newline + 1 + chunk_size;
+            }
 
-        if (std::isalpha(*content.begin()) || *content.begin() == '_') {
-            for (std::string::iterator s = content.begin() + 1; s < content.end(); s++) {
-                if (!std::isalnum(*s) && *s != '_') {
-                    return false;
+            if (change >= m_content.size()) break;
+
+            char c = m_content[change];
+            if (c == static_cast<char>(0xff)) {
+                boundaries.push_back(change);
+                return boundaries;
+            }
+
+            else if (c == '/') {
+                if (change + 1 < m_content.size() && m_content[change + 1] == '/') {
+                    pos = scan::findByte(m_content, change, '\n');
+                } else if (change + 1 < m_content.size() && m_content[change + 1] == '*') {
+                    std::size_t end = scan::blockCommentEnd(m_content, change + 2);
+                    if (end >= m_content.size()) break;
+                    pos = end + 2;
+                } else {
+                    pos = change + 1;
                 }
             }
 
-            return true;
+            else if (c == '"') {
+                pos = change + 1;
+                while (pos < m_content.size() && m_content[pos] != '"') {
+                    pos = scan::stringBodyEnd(m_content, pos);
+                    if (pos < m_content.size() && m_content[pos] != '"') {
+                        pos += m_content[pos] == '\\' && pos + 1 < m_content.size() ? 2 : 1;
+                    }
+                }
+                if (pos >= m_content.size()) break;
+                pos++;
+            }
+
+            else {
+                pos = change + 1;
+                if (pos < m_content.size() && m_content[pos] == '\\' && pos + 1 < m_content.size()) {
+                    pos += 2;
+                } else if (pos < m_content.size()) {
+                    pos++;
+                }
+                if (pos >= m_content.size() || m_content[pos] != '\'') break;
+                pos++;
+            }
         }
 
-        return false;
+        boundaries.push_back(m_content.size());
+        return boundaries;
     }
 
-    bool isInt(std::string content) {
-        printDebug("checking is int");
-        for (std::string::iterator s = content.begin(); s < content.end(); s++) {
-            if (!std::isdigit(*s)) return false;
+    /*
+        Tokenizes the whole input like tokenize(), with the chunks from
+        findChunkBoundaries() lexed on `threads` threads. Each chunk interns
+        into its own SymbolTable and LiteralTable, the ids are mapped to
+        global ones in chunk order so they come out the same as in a serial
+        run. A `+` or `-` opening a chunk is turned back into a binary
+        operator if the token before the seam says so.
+
+        If any chunk fails the input is lexed again serially so the error
+        carries the right position. Must be called on a fresh Tokenizer.
+    */
+    std::vector<Token> tokenizeParallel(unsigned int threads = ThreadPool::defaultThreadCount()) {
+        if (threads <= 1 || m_content.size() < PARALLEL_MIN_SIZE) {
+            return tokenize();
+        }
+
+        std::vector<std::size_t> boundaries = findChunkBoundaries(threads * 4);
+        std::size_t chunk_count = boundaries.size() - 1;
+
+        struct Chunk {
+            SymbolTable symbols;
+            LiteralTable literals;
+            std::unique_ptr<Tokenizer> tokenizer;
+            std::vector<Token> tokens;
+            std::exception_ptr error;
+        };
+        std::vector<Chunk> chunks(chunk_count);
+
+        ThreadPool pool(threads);
+        for (std::size_t i = 0; i < chunk_count; i++) {
+            Chunk& chunk = chunks[i];
+            chunk.tokenizer.reset(new Tokenizer(m_content, boundaries[i], boundaries[i + 1], m_source, chunk.symbols, chunk.literals));
+
+            pool.submit([&chunk] {
+                try {
+                    chunk.tokens = chunk.tokenizer->tokenize();
+                } catch (...) {
+                    chunk.error = std::current_exception();
+                }
+            });
         }
-        return true;
-    }
+        pool.wait();
 
-    bool isRange(std::string content) {
-        printDebug("checking is generator");
-        bool found_1 = false;
-        bool found_2 = false;
-        for (std::string::iterator s = content.begin(); s < content.end(); s++) {
-            if ((!std::isdigit(*s) && *s != '.') || (*s == '.' && found_1 && found_2)) return false;
-            
-            if (*s == '.' && found_1) found_2 = true;
-            else if (*s == '.') found_1 = true;
-            printDebug(std::string(1, *s) + " " + std::to_string(found_1) + " " + std::to_string(found_2));
+        for (Chunk& chunk : chunks) {
+            if (chunk.error) return tokenize();
         }
-        printDebug(std::to_string(found_1 && found_2));
-        return found_1 && found_2;
-    }
 
-    bool isNumber(std::string content) {
-        bool decimal = false;
-        for (std::string::iterator s = content.begin(); s < content.end(); s++) {
-            if (*s == '.' && !decimal) decimal = true;
-            else if (!std::isdigit(*s)) return false;
+        std::vector<std::size_t> first_token(chunk_count + 1, 0);
+        std::vector<std::vector<SymbolId>> symbol_map(chunk_count);
+        std::vector<std::vector<LiteralId>> literal_map(chunk_count);
+
+        for (std::size_t i = 0; i < chunk_count; i++) {
+            Chunk& chunk = chunks[i];
+            first_token[i + 1] = first_token[i] + chunk.tokens.size();
+
+            for (SymbolId id = 0; id < chunk.symbols.size(); id++) {
+                symbol_map[i].push_back(m_symbols->intern(chunk.symbols.name(id)));
+            }
+            for (LiteralId id = 0; id < chunk.literals.size(); id++) {
+                literal_map[i].push_back(m_literals->intern(chunk.literals.text(id)));
+            }
+
+            if (chunk.tokens.empty()) continue;
+
+            // chunks start with no previous token, so a leading `+` or `-` was lexed as unary
+            Token& first = chunk.tokens.front();
+            if ((first.getTokenType() == TokenType::_unary_plus || first.getTokenType() == TokenType::_unary_minus) && !isUnaryAfter(m_previous)) {
+                first.setTokenType(first.getTokenType() == TokenType::_unary_plus ? TokenType::_binary_plus : TokenType::_binary_minus);
+            }
+            m_previous = chunk.tokens.back().getTokenType();
+        }
+
+        std::vector<Token> tokens(first_token.back());
+        for (std::size_t i = 0; i < chunk_count; i++) {
+            pool.submit([&tokens, &chunks, &first_token, &symbol_map, &literal_map, i] {
+                Token* out = tokens.data() + first_token[i];
+                for (const Token& token : chunks[i].tokens) {
+                    *out = token;
+                    if (token.getSymbol() != NO_SYMBOL) {
+                        out->setSymbol(symbol_map[i][token.getSymbol()]);
+                    } else if (token.isLiteral()) {
+                        out->setLiteral(literal_map[i][token.getLiteral()]);
+                    }
+                    out++;
+                }
+            });
         }
-        return true;
+        pool.wait();
+
+        m_pos = m_content.size();
+        return tokens;
     }
 
-    std::vector<Token> tokenize() {
-        std::string buffer;
-        int line = 0;
-        int _char = 0;
+    /*
+        Updates `tokens`, the tokens this Tokenizer produced for its current
+        input, after `edit` turned that input into `content`.
+
+        Lexing restarts at the start of the last token that ends before the
+        edit, with the previous token type it had the first time. It stops as
+        soon as it produces a token past the edit that matches an old token at
+        the same shifted offset. From there on the lexer would repeat itself,
+        so the old tokens are only moved by the size of the edit. Lines and
+        columns follow from the offsets.
+
+        This Tokenizer's SourceMap entry is pointed at `content`, so `tokens`
+        must come from this object.
+    */
+    void relex(std::string_view content, std::vector<Token>& tokens, const TextEdit& edit) {
+        std::size_t old_edit_end = edit.offset + edit.removed;
+        std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(edit.inserted.size()) - static_cast<std::ptrdiff_t>(edit.removed);
 
-        for (std::string::iterator it = m_content.begin(); it < m_content.end(); it++)
-        {
-            // printDebug(std::string(1, *it) + " at " + std::to_string(line) + ":" + std::to_string(_char));
+        // tokens ending before the edit cannot change, the one touching it may grow into it
+        std::size_t restart = std::partition_point(tokens.begin(), tokens.end(), [&](const Token& token) {
+            return token.getOffset() + token.getLength() < edit.offset;
+        }) - tokens.begin();
+        restart = restart > 0 ? restart - 1 : 0;
 
-            if (*it == EOF) {
-                break;
+        // first old token that lies entirely after the edit
+        std::size_t old_next = std::partition_point(tokens.begin() + restart, tokens.end(), [&](const Token& token) {
+            return token.getOffset() < old_edit_end;
+        }) - tokens.begin();
+
+        m_content = content;
+        SourceMap::global().replace(m_source, content);
+        m_lookahead_count = 0;
+        if (restart < tokens.size() && tokens[restart].getOffset() <= edit.offset) {
+            m_pos = tokens[restart].getOffset();
+        } else {
+            m_pos = 0;
+        }
+        m_previous = restart > 0 ? std::optional<TokenType>(tokens[restart - 1].getTokenType()) : std::nullopt;
+
+        std::vector<Token> fresh;
+        std::size_t resync = tokens.size();
+        for (Token token = lexNext(); token.getTokenType() != TokenType::_eof; token = lexNext()) {
+            while (old_next < tokens.size() && tokens[old_next].getOffset() + shift < token.getOffset()) {
+                old_next++;
             }
 
-            else if (std::isspace(*it) && buffer.empty()) {
-                if (*it == '\n') {
-                    line++;
-                    _char = 0;
-                    if (!buffer.empty()) {
-                        m_tokens.push_back(getToken(buffer, line, _char));
-                    }
-                    buffer = "";
-                    continue;
+            const Token* old = old_next < tokens.size() ? &tokens[old_next] : nullptr;
+            if (old && old->getOffset() + shift == token.getOffset() && old->getTokenType() == token.getTokenType() && old->getLength() == token.getLength()) {
+                resync = old_next;
+                for (std::size_t i = resync; i < tokens.size(); i++) {
+                    tokens[i].setOffset(tokens[i].getOffset() + shift);
                 }
+                break;
             }
 
-            // handle token when space is encountered
-            else if (std::isspace(*it)) {
-                m_tokens.push_back(getToken(buffer, line, _char));
-                buffer = "";
-
-            }
+            fresh.push_back(token);
+        }
 
-            // handle single unique characters that may not have a space before them
-            else if (*it == ';' || *it == '{' || *it == '}' || *it == '(' || *it == ')' || *it == '[' || *it == ']' || *it == '"' || *it == '"' || *it == '\'' || *it == '=' || *it == '.' || *it == ',' || *it == '<' || *it == '>' || *it == '.' || *it == ',' || *it == '+' || *it == '-' || *it == '*' || *it == '/' || *it == '|' || *it == '%' || *it == '&' || *it == '^') {
-
-
-                if (buffer == "") {
-                    // handle double characters
-                    if ((it + 1 < m_content.end()) && (
-                            (*it == '-' && *(it + 1) == '>') ||     // handle `->`
-                            (*it == '<' && *(it + 1) == '-') ||     // handle `<-`
-                            (*it == '/' && *(it + 1) == '/') ||     // handle `//`
-                            (*it == '/' && *(it + 1) == '/') ||     // handle `//`
-                            (*it == '/' && *(it + 1) == '*') ||     // handle `/*`
-                            (*it == '>' && *(it + 1) == '=') ||     // handle `>=`
-                            (*it == '<' && *(it + 1) == '=') ||     // handle `<=`
-                            (*it == '<' && *(it + 1) == '<') ||     // handle `<<`
-                            (*it == '>' && *(it + 1) == '>') ||     // handle `>>`
-                            (*it == '.' && *(it + 1) == '.') ||     // handle `..`
-                            (*it == '*' && *(it + 1) == '*') ||     // handle `**`
-                            (*it == '!' && *(it + 1) == '=') ||     // handle `!=`
-                            (*it == '|' && *(it + 1) == '|') ||     // handle `||`
-                            (*it == '=' && *(it + 1) == '=')        // handle `==`
-                    )) {
-                        // handle inline comments
-                        if (*it == '/' && it + 1 < m_content.end() && *(it + 1) == '/') {
-                            while (*it != '\n') {
-                                buffer += *it;
-                                _char++;
-                                it++;
-                            }
-                        } 
-
-                        // handle multi-line comments
-                        else if (*it == '/' && *(it + 1) == '*') {
-                            buffer += "/*";
-                            _char += 2;
-                            it += 2;
-
-                            while (*it != '*' || it + 1 < m_content.end() && *(it + 1) != '/') {
-                                if (*it == '\n') line++;
-                                else _char++;
-                                buffer += *it;
-                                _char++;
-                                it++;
-                            }
-
-                            if (*it == '*' && it + 1 < m_content.end() && *(it + 1) == '/') {
-                                buffer += *it;
-                                _char++;
-                                it++;
-                                buffer += *it;
-                            }
-                        } 
-                        
-                        else {
-                            if (*it == '\n') line++;
-                            else _char++;
-
-                            buffer += *it;
-                            buffer += *(it + 1);
-                            it++;
-                        }
-                    } 
-
-                    else {
-                        buffer = *it;
-                    }
-                    
-
-                    Token token = getToken(buffer, line, _char);
-                    
-                    // handle string
-                    if (token.getTokenType() == TokenType::_dbl_quote) {
-                        printDebug("Handing string");
-                        buffer = "";
-
-                        it++;
-                        _char++;
-                        while (it < m_content.end() && *it != '"') {
-                            printDebug(buffer);
-                            if (*it == '\\' && it + 1 < m_content.end()) {
-                                printDebug("Found an escape character");
-                                printDebug(std::string(1, *(it + 1)));
-
-                                if (*(it + 1) == '0') {
-                                    buffer += '\0';
-
-                                } else if (*(it + 1) == 'a') {
-                                    buffer += '\a';
-
-                                } else if (*(it + 1) == 'b') {
-                                    buffer += '\b';
-
-                                } else if (*(it + 1) == 't') {
-                                    buffer += '\t';
-                                
-                                } else if (*(it + 1) == 'n') {
-                                    buffer += '\n';
-
-                                } else if (*(it + 1) == 'r') {
-                                    buffer += '\r';
-                                
-                                } else if (*(it + 1) == '"') {
-                                    buffer += "\"";
-
-                                } else if (*(it + 1) == '\'') {
-                                    buffer += "'";
-
-                                } else if (*(it + 1) == '\\') {
-                                    buffer += '\\';
-                                }
-
-                                it += 2;
-                                _char += 2;
-
-                            } else {
-                                buffer += *it;
-    
-                                if (*it == '\n') line++;
-    
-                                it++;
-                                _char++;
-                            }
-                        }
-
-                        m_tokens.push_back(Token(TokenType::_text, "`string`: \"" + buffer + "\"", line, _char));
-                        buffer = (*it);
-                        printDebug(buffer);
-                        token = getToken(buffer, line, _char);
-                        if (token.getTokenType() != TokenType::_dbl_quote) {
-                            printError("Expected `\"`", token.getLine(), token.getChar());
-                        }
-
-                        buffer = "";
-                    }
+        // overwrite in place and only move the tail when the token count changed
+        std::size_t replaced = resync - restart;
+        std::size_t common = std::min(replaced, fresh.size());
+        std::copy(fresh.begin(), fresh.begin() + common, tokens.begin() + restart);
+        if (fresh.size() > replaced) {
+            tokens.insert(tokens.begin() + resync, fresh.begin() + common, fresh.end());
+        } else {
+            tokens.erase(tokens.begin() + restart + common, tokens.begin() + resync);
+        }
 
-                    else if (token.getTokenType() == TokenType::_sgl_quote) {
-                        buffer = "";
-                        it++;
-                        _char++;
-
-                        if (*it == '\\' && it + 1 < m_content.end()) {
-                            printDebug("Found an escape character");
-                            printDebug(std::string(1, *(it + 1)));
-
-                            if (*(it + 1) == '0') {
-                                buffer += '\0';
-
-                            } else if (*(it + 1) == 'a') {
-                                buffer += '\a';
-
-                            } else if (*(it + 1) == 'b') {
-                                buffer += '\b';
-
-                            } else if (*(it + 1) == 't') {
-                                buffer += '\t';
-                            
-                            } else if (*(it + 1) == 'n') {
-                                buffer += '\n';
-
-                            } else if (*(it + 1) == 'r') {
-                                buffer += '\r';
-                            
-                            } else if (*(it + 1) == '"') {
-                                buffer += "\"";
-
-                            } else if (*(it + 1) == '\'') {
-                                buffer += "'";
-
-                            } else if (*(it + 1) == '\\') {
-                                buffer += '\\';
-                            }
-
-                            
-                        } else {
-                            buffer += *it;
-                        }
-                        it++;
-                        _char += 1;
-
-                        if (token.getTokenType() != TokenType::_sgl_quote) {
-                            printError("Exected `'`", line, _char);
-                        } else {
-                            m_tokens.push_back(Token(TokenType::_char_lit, "`character`: '" + buffer + "'", line, _char));
-                        }
-                    }
+        m_pos = m_content.size();
+        m_lookahead_count = 0;
+    }
 
-                    // skip comments
-                    else if (token.getTokenType() != TokenType::_comment) m_tokens.push_back(token);
-                    
+    void print_tokens(const std::vector<Token>& tokens) {
+        LOG_DEBUG("tokens array size " + std::to_string(tokens.size()));
+        for (auto it = tokens.begin(); it < tokens.end(); it++) {
+            LOG_DEBUG( "::" + std::string((*it).getStrValue()));
+        }
+        return;
+    }
+};
 
-                    buffer = "";
+/*
+    Random access over the parser's tokens, which come one of two ways:
+
+    * pulled from a Tokenizer as the parser reaches them, into a deque so
+      their addresses stay valid while the stream grows
+    * handed over whole as a vector that is moved in and never copied or
+      resized again, the `_eof` token is kept in its own allocation rather
+      than appended, which could reallocate the vector
+
+    Either way the stream owns the tokens and they stay where they are for
+    as long as it lives, also when it is moved, so the AST can keep pointers
+    to them. Their kinds are also kept in one contiguous array, so lookahead
+    checks that only compare kinds stay within a cache line or two. Reading
+    past the end returns the `_eof` token.
+
+    A vector-mode stream can hand out views, streams that read the same
+    tokens without owning them, so several parsers on different threads can
+    build ASTs that all point into one token buffer.
+*/
+class TokenStream {
+private:
+    Tokenizer* m_tokenizer = nullptr;
+    std::deque<Token> m_streamed;
+    std::vector<Token> m_tokens;
+    std::unique_ptr<Token> m_eof;
+    std::vector<TokenType> m_kinds;
 
-                } 
-                
-                // handle .
-                else {
-                    if (isNumber(buffer) && *it == '.' && buffer.find('.') == std::string::npos) {
-                        buffer += '.';
-                    }
-                    else {
-                        if (buffer.back() == '.' && *it == '.') {
-                            buffer.pop_back();
-                            it--;
-                            _char--;
-                        }
+    // what the vector mode reads, this stream's own buffers or the ones it views
+    Token* m_data = nullptr;
+    std::size_t m_size = 0;
+    const TokenType* m_kind_data = nullptr;
+    Token* m_end = nullptr;
 
-                        if (!buffer.empty()) {
-                            m_tokens.push_back(getToken(buffer, line, _char));
-                        }
+    // pulls tokens until `index` exists or the `_eof` token has been reached
+    void fill(std::size_t index) {
+        while (index >= m_kinds.size() && (m_kinds.empty() || m_kinds.back() != TokenType::_eof)) {
+            m_streamed.push_back(m_tokenizer->next());
+            m_kinds.push_back(m_streamed.back().getTokenType());
+        }
+    }
 
-                        buffer.clear();
+public:
+    TokenStream() : TokenStream(std::vector<Token>()) {}
 
-                        it--;
-                        _char--;
-                    }
-                }
-            }
+    explicit TokenStream(Tokenizer& tokenizer) : m_tokenizer(&tokenizer) {}
 
-            else {
-                buffer += (*it);
-            }
+    explicit TokenStream(std::vector<Token>&& tokens) : m_tokens(std::move(tokens)) {
+        std::size_t end = m_tokens.empty() ? 0 : m_tokens.back().getOffset() + m_tokens.back().getLength();
+        m_eof.reset(new Token(TokenType::_eof, m_tokens.empty() ? NO_SOURCE : m_tokens.back().getSource(), end, 0));
 
-            _char++;
+        m_kinds.resize(m_tokens.size() + 1);
+        for (std::size_t i = 0; i < m_tokens.size(); i++) {
+            m_kinds[i] = m_tokens[i].getTokenType();
         }
-        
-        if (!buffer.empty()) {
-            m_tokens.push_back(getToken(buffer, line, _char));
-            buffer = "";
+        m_kinds.back() = TokenType::_eof;
+
+        m_data = m_tokens.data();
+        m_size = m_tokens.size();
+        m_kind_data = m_kinds.data();
+        m_end = m_eof.get();
+    }
+
+    // a stream over the same tokens, this one must outlive it; vector mode only
+    TokenStream view() {
+        TokenStream stream;
+        stream.m_data = m_data;
+        stream.m_size = m_size;
+        stream.m_kind_data = m_kind_data;
+        stream.m_end = m_end;
+        return stream;
+    }
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+    TokenStream(TokenStream&&) = default;
+    TokenStream& operator=(TokenStream&&) = default;
+
+    Token& at(std::size_t index) {
+        if (!m_tokenizer) {
+            return index < m_size ? m_data[index] : *m_end;
         }
 
-        return m_tokens;
+        fill(index);
+        return index < m_streamed.size() ? m_streamed[index] : m_streamed.back();
     }
 
-    void print_tokens() {
-        printDebug("tokens array size " + std::to_string(m_tokens.size()));
-        for (auto it = m_tokens.begin(); it < m_tokens.end(); it++) {
-            printDebug( "::" + (*it).getStrValue());
+    TokenType kind(std::size_t index) {
+        if (!m_tokenizer) {
+            return m_kind_data[std::min(index, m_size)];
         }
-        return;
+
+        fill(index);
+        return index < m_kinds.size() ? m_kinds[index] : m_kinds.back();
+    }
+
+    // number of tokens pulled so far, including the `_eof` token once it has been reached
+    std::size_t size() const {
+        return m_tokenizer ? m_streamed.size() : m_size + 1;
+    }
+
+    // true if every token is already here, which is what parsing on several threads needs
+    bool complete() const {
+        return !m_tokenizer;
     }
 };